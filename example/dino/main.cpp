@@ -143,10 +143,13 @@ class simple_physics_system {
 public:
     static void update(seconds delta, tree_context &ctx) {
         auto &reg = ctx.ecs();
-        for(auto [en, tf, rg]: reg.each<mut<transform>, mut<my_rigidbody>>()) {
+        // Listeners receive one notification per component type instead of one per entity
+        const auto batch = reg.batch<comp_event::update, transform, my_rigidbody>();
+        // Integration only touches the entity's own components, so it can run on worker threads
+        reg.par_each<mut<transform>, mut<my_rigidbody>>([delta](entity, auto tf, auto rg) {
             rg->velocity += rg->acceleration * delta;
             tf->translate(rg->velocity * delta);
-        }
+        });
         for(auto [en, tf, rg, box]: reg.each<mut<transform>, my_rigidbody, bounding_box>()) {
             const auto bottom = tf->position().y - (box->size.y / 2.F);
             if(bottom < 0) {
@@ -1,10 +1,13 @@
 module;
 
-#include <any>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <typeindex>
+#include <cstddef>
+#include <stdexcept>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 export module stay3.core:any_map;
 
@@ -15,28 +18,47 @@ using key_type = std::size_t;
 template<typename id>
 concept any_map_key = requires(id key) { static_cast<key_type>(key); };
 
+/**
+ * @brief Dense index of `type` among all types ever stored in an `any_map`, assigned on first use
+ */
+std::size_t next_type_slot() {
+    static std::atomic<std::size_t> counter;
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename type>
+std::size_t type_slot() {
+    static const std::size_t slot = next_type_slot();
+    return slot;
+}
+
 export class any_map {
 public:
     using key_type = st::key_type;
 
+    any_map() = default;
+    ~any_map() = default;
+    any_map(const any_map &) = delete;
+    any_map(any_map &&) noexcept = default;
+    any_map &operator=(const any_map &) = delete;
+    any_map &operator=(any_map &&) noexcept = default;
+
     template<typename type, typename... args>
     type &emplace(args &&...arguments) {
-        auto type_id = std::type_index{typeid(type)};
-        assert(!m_variables.contains(type_id) && "Type already exists!");
-        return std::any_cast<type &>(m_variables.emplace(type_id, std::make_any<type>(std::forward<args>(arguments)...)).first->second);
+        return emplace_in<type>(m_variables, std::forward<args>(arguments)...);
     }
 
     template<typename type, any_map_key id, typename... args>
     type &emplace_as(id key, args &&...arguments) {
-        auto &type_map = m_named_variables[static_cast<key_type>(key)];
-        auto type_id = std::type_index{typeid(type)};
-        assert(!type_map.contains(type_id) && "Named type already exists!");
-        return std::any_cast<type &>(type_map.emplace(type_id, std::make_any<type>(std::forward<args>(arguments)...)).first->second);
+        return emplace_in<type>(m_named_variables[static_cast<key_type>(key)], std::forward<args>(arguments)...);
     }
 
+    /**
+     * @throw `std::out_of_range` if there is no variable of `type`
+     */
     template<typename type>
     const type &get() const {
-        return std::any_cast<const type &>(m_variables.at(std::type_index{typeid(type)}));
+        return get_in<type>(m_variables);
     }
 
     template<typename type>
@@ -46,23 +68,38 @@ public:
 
     template<typename type, any_map_key id>
     const type &get(id key) const {
-        const auto &type_map = m_named_variables.at(static_cast<key_type>(key));
-        return std::any_cast<const type &>(type_map.at(std::type_index{typeid(type)}));
+        return get_in<type>(m_named_variables.at(static_cast<key_type>(key)));
+    }
+
+    /**
+     * @return Pointer to the variable of `type`, or `nullptr` if there is none
+     */
+    template<typename type>
+    [[nodiscard]] type *find() {
+        const auto slot = type_slot<type>();
+        return slot < m_variables.size() ? static_cast<type *>(m_variables[slot].object) : nullptr;
     }
 
     template<typename type>
     void erase() {
-        m_variables.erase(std::type_index{typeid(type)});
+        const auto slot = type_slot<type>();
+        if(slot < m_variables.size()) {
+            m_variables[slot] = {};
+        }
     }
 
     template<typename type, any_map_key id>
     void erase(id key) {
         auto it = m_named_variables.find(static_cast<key_type>(key));
-        if(it != m_named_variables.end()) {
-            it->second.erase(std::type_index{typeid(type)});
-            if(it->second.empty()) {
-                m_named_variables.erase(it);
-            }
+        if(it == m_named_variables.end()) {
+            return;
+        }
+        const auto slot = type_slot<type>();
+        if(slot < it->second.size()) {
+            it->second[slot] = {};
+        }
+        if(std::ranges::all_of(it->second, [](const variable &var) { return var.object == nullptr; })) {
+            m_named_variables.erase(it);
         }
     }
 
@@ -72,7 +109,59 @@ public:
     }
 
 private:
-    std::unordered_map<std::type_index, std::any> m_variables;
-    std::unordered_map<key_type, std::unordered_map<std::type_index, std::any>> m_named_variables;
+    /**
+     * @brief Owning type-erased pointer, the object never moves
+     */
+    struct variable {
+        void *object{};
+        void (*destroy)(void *){};
+
+        variable() = default;
+        variable(void *object, void (*destroy)(void *))
+            : object{object}, destroy{destroy} {}
+        ~variable() {
+            if(object != nullptr) {
+                destroy(object);
+            }
+        }
+        variable(const variable &) = delete;
+        variable(variable &&other) noexcept
+            : object{std::exchange(other.object, nullptr)}, destroy{other.destroy} {}
+        variable &operator=(const variable &) = delete;
+        variable &operator=(variable &&other) noexcept {
+            variable{std::move(other)}.swap(*this);
+            return *this;
+        }
+        void swap(variable &other) noexcept {
+            std::swap(object, other.object);
+            std::swap(destroy, other.destroy);
+        }
+    };
+    // Indexed by `type_slot`
+    using variables = std::vector<variable>;
+
+    template<typename type, typename... args>
+    static type &emplace_in(variables &vars, args &&...arguments) {
+        const auto slot = type_slot<type>();
+        if(slot >= vars.size()) {
+            vars.resize(slot + 1);
+        }
+        assert(vars[slot].object == nullptr && "Type already exists!");
+        auto *object = new type(std::forward<args>(arguments)...);
+        vars[slot] = variable{object, [](void *erased) { delete static_cast<type *>(erased); }};
+        return *object;
+    }
+
+    template<typename type>
+    static const type &get_in(const variables &vars) {
+        const auto slot = type_slot<type>();
+        if(slot >= vars.size() || vars[slot].object == nullptr) {
+            throw std::out_of_range{"No variable of requested type"};
+        }
+        return *static_cast<const type *>(vars[slot].object);
+    }
+
+    variables m_variables;
+    std::unordered_map<key_type, variables> m_named_variables;
 };
 } // namespace st
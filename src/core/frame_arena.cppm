@@ -0,0 +1,90 @@
+module;
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+export module stay3.core:frame_arena;
+
+export namespace st {
+/**
+ * @brief Linear memory for containers that do not outlive the current frame
+ *
+ * Allocations bump a pointer inside one buffer, deallocations do nothing and `reset` frees everything at once.
+ * Allocations not fitting the buffer go to the heap, then the next `reset` grows the buffer to fit them
+ * @note Not thread safe
+ */
+class frame_arena {
+public:
+    static constexpr std::size_t default_capacity = std::size_t{256} * 1024;
+
+    explicit frame_arena(std::size_t capacity = default_capacity)
+        : m_buffer{std::make_unique_for_overwrite<std::byte[]>(capacity)}, m_capacity{capacity} {
+        m_resource.emplace(m_buffer.get(), m_capacity, &m_overflow);
+    }
+    ~frame_arena() = default;
+    frame_arena(const frame_arena &) = delete;
+    frame_arena &operator=(const frame_arena &) = delete;
+    frame_arena(frame_arena &&) noexcept = delete;
+    frame_arena &operator=(frame_arena &&) noexcept = delete;
+
+    /**
+     * @brief Memory resource for `std::pmr` containers, the pointer stays the same across `reset`
+     */
+    [[nodiscard]] std::pmr::memory_resource *resource() {
+        return &*m_resource;
+    }
+
+    /**
+     * @brief Frees every allocation, containers using the arena must be gone by then
+     */
+    void reset() {
+        m_resource.reset();
+        if(m_overflow.bytes > 0) {
+            m_capacity += m_overflow.bytes;
+            m_buffer = std::make_unique_for_overwrite<std::byte[]>(m_capacity);
+        }
+        m_overflow.allocations = 0;
+        m_overflow.bytes = 0;
+        m_resource.emplace(m_buffer.get(), m_capacity, &m_overflow);
+    }
+
+    [[nodiscard]] std::size_t capacity() const {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Heap allocations since the last `reset`, zero while frames fit the buffer
+     */
+    [[nodiscard]] std::size_t overflow_count() const {
+        return m_overflow.allocations;
+    }
+
+private:
+    class overflow_resource: public std::pmr::memory_resource {
+    public:
+        std::size_t allocations{};
+        std::size_t bytes{};
+
+    private:
+        void *do_allocate(std::size_t size, std::size_t alignment) override {
+            ++allocations;
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, alignment);
+        }
+        void do_deallocate(void *pointer, std::size_t size, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+        }
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> m_buffer;
+    std::size_t m_capacity;
+    // Outlives `m_resource`, which returns overflow chunks on destruction
+    overflow_resource m_overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+};
+} // namespace st
@@ -1,9 +1,12 @@
 module;
 
+#include <algorithm>
 #include <cassert>
 #include <concepts>
+#include <cstddef>
 #include <limits>
-#include <unordered_set>
+#include <stdexcept>
+#include <vector>
 
 export module stay3.core:id_generator;
 
@@ -16,18 +19,89 @@ public:
             assert(m_next_max_id < std::numeric_limits<type>::max() && "Id limit exceeded");
             return m_next_max_id++;
         }
-        const auto result = *m_available_ids.begin();
-        m_available_ids.erase(result);
+        const auto result = m_available_ids.back();
+        m_available_ids.pop_back();
         return result;
     }
     void recycle(type id) {
         assert(id < m_next_max_id && "Invalid id");
-        assert(!m_available_ids.contains(id) && "Id was recycled");
-        m_available_ids.insert(id);
+        assert(!std::ranges::contains(m_available_ids, id) && "Id was recycled");
+        m_available_ids.push_back(id);
     }
 
 private:
-    std::unordered_set<type> m_available_ids;
+    std::vector<type> m_available_ids;
     type m_next_max_id{};
 };
+
+/**
+ * @brief Generates ids made of a dense index in the low bits and a generation in the high bits
+ *
+ * Recycling an id bumps the generation of its index, so stale copies are told apart from the reused id.
+ * Indices are reused in LIFO order and stay small enough to index a vector.
+ * At most `max_alive` ids exist at once, 2^20 for 32-bit ids
+ */
+template<std::unsigned_integral type>
+class generational_id_generator {
+public:
+    static constexpr int generation_bits = std::numeric_limits<type>::digits * 3 / 8;
+    static constexpr int index_bits = std::numeric_limits<type>::digits - generation_bits;
+    static constexpr type index_mask = (type{1} << index_bits) - 1;
+    static constexpr type generation_mask = (type{1} << generation_bits) - 1;
+    static constexpr std::size_t max_alive = std::size_t{index_mask} + 1;
+
+    /**
+     * @throw `std::length_error` if `max_alive` ids are alive
+     */
+    [[nodiscard]] type create() {
+        if(m_available_indices.empty()) {
+            if(m_generations.size() >= max_alive) {
+                throw std::length_error{"Id limit exceeded"};
+            }
+            m_generations.push_back(0);
+            return make(static_cast<type>(m_generations.size() - 1), 0);
+        }
+        const auto index = m_available_indices.back();
+        m_available_indices.pop_back();
+        return make(index, m_generations[index]);
+    }
+
+    void recycle(type id) {
+        assert(is_alive(id) && "Invalid or recycled id");
+        const auto index = index_of(id);
+        m_generations[index] = static_cast<type>((m_generations[index] + 1) & generation_mask);
+        m_available_indices.push_back(index);
+    }
+
+    /**
+     * @brief Whether `id` was created and not recycled since
+     * @note Generations wrap around, so an id whose index was recycled `2^generation_bits` times is seen as alive again
+     */
+    [[nodiscard]] bool is_alive(type id) const {
+        const auto index = index_of(id);
+        return index < m_generations.size() && m_generations[index] == generation_of(id);
+    }
+
+    /**
+     * @brief Number of indices ever used, every index is less than this
+     */
+    [[nodiscard]] std::size_t capacity() const {
+        return m_generations.size();
+    }
+
+    [[nodiscard]] static constexpr type index_of(type id) {
+        return id & index_mask;
+    }
+    [[nodiscard]] static constexpr type generation_of(type id) {
+        return static_cast<type>(id >> index_bits);
+    }
+
+private:
+    static constexpr type make(type index, type generation) {
+        return static_cast<type>((generation << index_bits) | index);
+    }
+
+    std::vector<type> m_generations;
+    std::vector<type> m_available_indices;
+};
 } // namespace st
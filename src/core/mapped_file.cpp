@@ -0,0 +1,96 @@
+module;
+
+#include <cstddef>
+#include <filesystem>
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+module stay3.core;
+
+namespace st {
+mapped_file::mapped_file(const std::filesystem::path &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        throw file_error{"Failed to open: " + path.string()};
+    }
+    LARGE_INTEGER size{};
+    if(GetFileSizeEx(file, &size) == 0) {
+        CloseHandle(file);
+        throw file_error{"Failed to determine file size: " + path.string()};
+    }
+    if(size.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(mapping == nullptr) {
+        throw file_error{"Failed to map: " + path.string()};
+    }
+    // The view keeps the mapping object alive
+    const auto *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(view == nullptr) {
+        throw file_error{"Failed to map: " + path.string()};
+    }
+    m_data = static_cast<const std::byte *>(view);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw file_error{"Failed to open: " + path.string()};
+    }
+    struct stat info{};
+    if(fstat(fd, &info) != 0) {
+        close(fd);
+        throw file_error{"Failed to determine file size: " + path.string()};
+    }
+    if(info.st_size == 0) {
+        close(fd);
+        return;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    // The mapping stays valid after the descriptor is closed
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) {
+        throw file_error{"Failed to map: " + path.string()};
+    }
+#    ifndef __EMSCRIPTEN__
+    madvise(view, size, MADV_SEQUENTIAL);
+#    endif
+    m_data = static_cast<const std::byte *>(view);
+    m_size = size;
+#endif
+}
+
+mapped_file::~mapped_file() {
+    unmap();
+}
+
+void mapped_file::unmap() noexcept {
+    if(m_data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<std::byte *>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+} // namespace st
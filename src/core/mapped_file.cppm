@@ -0,0 +1,44 @@
+module;
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+export module stay3.core:mapped_file;
+
+export namespace st {
+/**
+ * @brief Read-only memory mapping of a whole file
+ */
+class mapped_file {
+public:
+    /**
+     * @throw `file_error` if the file cannot be opened or mapped
+     */
+    explicit mapped_file(const std::filesystem::path &path);
+    ~mapped_file();
+    mapped_file(const mapped_file &) = delete;
+    mapped_file(mapped_file &&other) noexcept
+        : m_data{std::exchange(other.m_data, nullptr)}, m_size{std::exchange(other.m_size, 0)} {}
+    mapped_file &operator=(const mapped_file &) = delete;
+    mapped_file &operator=(mapped_file &&other) noexcept {
+        if(this != &other) {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] std::span<const std::byte> data() const {
+        return {m_data, m_size};
+    }
+
+private:
+    void unmap() noexcept;
+
+    const std::byte *m_data{};
+    std::size_t m_size{};
+};
+} // namespace st
@@ -4,15 +4,19 @@ export import :any_map;
 export import :color;
 export import :error;
 export import :file;
+export import :frame_arena;
 export import :id_generator;
 export import :logger;
+export import :mapped_file;
 export import :math_ops;
 export import :math;
 export import :matrix;
 export import :quaternion;
 export import :rect;
 export import :signal;
+export import :thread_pool;
 export import :time;
 export import :transform;
+export import :trs_kernel;
 export import :variant_helper;
 export import :vector;
\ No newline at end of file
@@ -0,0 +1,120 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+module stay3.core;
+
+namespace st {
+namespace {
+// Set on pool workers and on callers inside `parallel_for`, nested loops then run serially
+thread_local bool inside_parallel_region = false;
+} // namespace
+
+thread_pool::thread_pool([[maybe_unused]] std::size_t thread_count) {
+#ifndef __EMSCRIPTEN__
+    if(thread_count == 0) {
+        thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    m_workers.reserve(thread_count - 1);
+    for(std::size_t i = 1; i < thread_count; ++i) {
+        m_workers.emplace_back([this]() { worker_loop(); });
+    }
+#endif
+}
+
+thread_pool::~thread_pool() {
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_stopping = true;
+    }
+    m_job_available.notify_all();
+    for(auto &worker: m_workers) {
+        worker.join();
+    }
+}
+
+void thread_pool::run(std::size_t chunk_count, void *data, job_func job) {
+    if(m_workers.empty() || chunk_count == 1 || inside_parallel_region) {
+        for(std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            job(data, chunk);
+        }
+        return;
+    }
+
+    const std::scoped_lock dispatch_lock{m_dispatch_mutex};
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_job_data = data;
+        m_job = job;
+        m_chunk_count = chunk_count;
+        m_next_chunk.store(0, std::memory_order_relaxed);
+        m_failed.store(false, std::memory_order_relaxed);
+        m_error = nullptr;
+        m_busy_workers = m_workers.size();
+        ++m_generation;
+    }
+    m_job_available.notify_all();
+
+    inside_parallel_region = true;
+    work_on_current_job();
+    inside_parallel_region = false;
+
+    std::unique_lock lock{m_mutex};
+    m_job_done.wait(lock, [this]() { return m_busy_workers == 0; });
+    m_job = nullptr;
+    if(m_error) {
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+}
+
+void thread_pool::worker_loop() {
+    inside_parallel_region = true;
+    std::uint64_t seen_generation{};
+    while(true) {
+        {
+            std::unique_lock lock{m_mutex};
+            m_job_available.wait(lock, [&]() { return m_stopping || m_generation != seen_generation; });
+            if(m_stopping) {
+                return;
+            }
+            seen_generation = m_generation;
+        }
+        work_on_current_job();
+        {
+            const std::scoped_lock lock{m_mutex};
+            --m_busy_workers;
+        }
+        m_job_done.notify_one();
+    }
+}
+
+void thread_pool::work_on_current_job() {
+    while(!m_failed.load(std::memory_order_relaxed)) {
+        const auto chunk = m_next_chunk.fetch_add(1, std::memory_order_relaxed);
+        if(chunk >= m_chunk_count) {
+            return;
+        }
+        try {
+            m_job(m_job_data, chunk);
+        } catch(...) {
+            const std::scoped_lock lock{m_mutex};
+            if(!m_error) {
+                m_error = std::current_exception();
+            }
+            m_failed.store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+thread_pool &default_thread_pool() {
+    static thread_pool pool;
+    return pool;
+}
+} // namespace st
@@ -0,0 +1,116 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module stay3.core:thread_pool;
+
+export namespace st {
+/**
+ * @brief Fixed size worker pool for data parallel loops
+ *
+ * The calling thread takes part in the work, so a pool of `n` threads spawns `n - 1` workers.
+ * Runs everything on the calling thread on Emscripten
+ */
+class thread_pool {
+public:
+    /**
+     * @param thread_count Number of threads including the calling one, 0 means hardware concurrency
+     */
+    explicit thread_pool(std::size_t thread_count = 0);
+    ~thread_pool();
+    thread_pool(const thread_pool &) = delete;
+    thread_pool(thread_pool &&) noexcept = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+    thread_pool &operator=(thread_pool &&) noexcept = delete;
+
+    /**
+     * @brief Number of threads including the calling one
+     */
+    [[nodiscard]] std::size_t thread_count() const {
+        return m_workers.size() + 1;
+    }
+
+    /**
+     * @brief Calls `func(begin, end)` for consecutive ranges of at most `grain` indices covering [0, count)
+     *
+     * Blocks until every range is processed. The first exception thrown by `func` is rethrown
+     * and the ranges not started yet are skipped. Nested calls run serially
+     */
+    template<typename func>
+        requires std::invocable<func &, std::size_t, std::size_t>
+    void parallel_for(std::size_t count, std::size_t grain, func &&fn) {
+        if(count == 0) {
+            return;
+        }
+        grain = std::max<std::size_t>(grain, 1);
+        const auto chunk_count = (count + grain - 1) / grain;
+        struct context {
+            std::remove_reference_t<func> *fn;
+            std::size_t count;
+            std::size_t grain;
+        } ctx{.fn = &fn, .count = count, .grain = grain};
+        run(chunk_count, &ctx, +[](void *data, std::size_t chunk) {
+            auto &job_ctx = *static_cast<context *>(data);
+            const auto begin = chunk * job_ctx.grain;
+            (*job_ctx.fn)(begin, std::min(begin + job_ctx.grain, job_ctx.count));
+        });
+    }
+
+    /**
+     * @brief Same as above, with a grain giving a few ranges per thread
+     */
+    template<typename func>
+        requires std::invocable<func &, std::size_t, std::size_t>
+    void parallel_for(std::size_t count, func &&fn) {
+        parallel_for(count, default_grain(count), std::forward<func>(fn));
+    }
+
+    /**
+     * @brief Grain used by `parallel_for` when none is specified
+     */
+    [[nodiscard]] std::size_t default_grain(std::size_t count) const {
+        constexpr std::size_t chunks_per_thread = 4;
+        return std::max<std::size_t>(count / (thread_count() * chunks_per_thread), 1);
+    }
+
+private:
+    using job_func = void (*)(void *, std::size_t);
+
+    void run(std::size_t chunk_count, void *data, job_func job);
+    void worker_loop();
+    void work_on_current_job();
+
+    std::vector<std::thread> m_workers;
+    // Serializes concurrent `parallel_for` calls from different threads
+    std::mutex m_dispatch_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_job_available;
+    std::condition_variable m_job_done;
+    std::uint64_t m_generation{};
+    bool m_stopping{};
+    std::size_t m_busy_workers{};
+
+    void *m_job_data{};
+    job_func m_job{};
+    std::size_t m_chunk_count{};
+    std::atomic<std::size_t> m_next_chunk;
+    std::atomic<bool> m_failed;
+    std::exception_ptr m_error;
+};
+
+/**
+ * @brief Lazily created pool shared by the engine
+ */
+thread_pool &default_thread_pool();
+} // namespace st
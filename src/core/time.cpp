@@ -19,4 +19,21 @@ seconds stop_watch::restart() {
 seconds stop_watch::time_since_start() const {
     return std::chrono::duration<float>(std_clock::now() - m_start_time).count();
 }
+
+tick_watch::tick_watch()
+    : m_last_restart_time{now()} {}
+
+ticks tick_watch::now() {
+    const auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::duration<ticks, std::nano>>(since_epoch).count();
+}
+
+ticks tick_watch::restart() {
+    const auto current = now();
+    return current - std::exchange(m_last_restart_time, current);
+}
+
+ticks tick_watch::elapsed() const {
+    return now() - m_last_restart_time;
+}
 } // namespace st
@@ -1,6 +1,7 @@
 module;
 
 #include <chrono>
+#include <cstdint>
 
 export module stay3.core:time;
 
@@ -26,4 +27,31 @@ private:
     time_point m_start_time;
     time_point m_last_restart_time;
 };
+
+/**
+ * @brief Nanoseconds as integer
+ */
+using ticks = std::int64_t;
+/**
+ * @brief Monotonic integer-tick timer, precise enough to time profiler zones
+ */
+class tick_watch {
+public:
+    tick_watch();
+    /**
+     * @brief Current time since an unspecified epoch
+     */
+    [[nodiscard]] static ticks now();
+    /**
+     * @brief Returns ticks since last restart
+     */
+    ticks restart();
+    /**
+     * @brief Returns ticks since last restart without restarting
+     */
+    [[nodiscard]] ticks elapsed() const;
+
+private:
+    ticks m_last_restart_time;
+};
 } // namespace st
@@ -1,5 +1,11 @@
 module;
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
@@ -7,33 +13,12 @@ module;
 module stay3.core;
 
 import :math_ops;
+import :trs_kernel;
 
 namespace st {
 transform::transform(const vec3f &position, const quaternionf &orientation, const vec3f &scale)
     : m_position{position}, m_orientation{orientation}, m_scale{scale} {}
 
-transform::transform(const transform &other)
-    : m_position{other.m_position}, m_orientation{other.m_orientation}, m_scale{other.m_scale} {}
-
-transform &transform::operator=(const transform &other) {
-    m_position = other.m_position;
-    m_orientation = other.m_orientation;
-    m_scale = other.m_scale;
-    if(other.m_transform_mat_ok) {
-        m_transform_mat_ok = true;
-        m_transform_mat = other.m_transform_mat;
-    } else {
-        m_transform_mat_ok = false;
-    }
-    if(other.m_inv_transform_mat_ok) {
-        m_inv_transform_mat_ok = true;
-        m_inv_transform_mat = other.m_inv_transform_mat;
-    } else {
-        m_inv_transform_mat_ok = false;
-    }
-    return *this;
-}
-
 transform &transform::rotate(const vec3f &axis, radians angle) {
     auto quat = quaternionf{axis.normalized(), angle};
 
@@ -43,27 +28,18 @@ transform &transform::rotate(const vec3f &axis, radians angle) {
 transform &transform::rotate(const quaternionf &quat) {
     m_orientation.rotate(quat);
 
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
-
     return *this;
 }
 
 transform &transform::translate(const vec3f &offset) {
     m_position += offset;
 
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
-
     return *this;
 }
 
 transform &transform::scale(const vec3f &scale) {
     m_scale = m_scale * scale;
 
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
-
     return *this;
 }
 
@@ -74,33 +50,21 @@ transform &transform::scale(float scale) {
 transform &transform::set_orientation(const vec3f &axis, radians angle) {
     m_orientation = quaternionf{axis.normalized(), angle};
 
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
-
     return *this;
 }
 
 transform &transform::set_orientation(const quaternionf &quat) {
     m_orientation = quat;
-
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
     return *this;
 }
 
 transform &transform::set_position(const vec3f &pos) {
     m_position = pos;
-
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
     return *this;
 }
 
 transform &transform::set_scale(const vec3f &scale) {
     m_scale = scale;
-
-    m_transform_mat_ok = false;
-    m_inv_transform_mat_ok = false;
     return *this;
 }
 
@@ -112,30 +76,51 @@ transform &transform::set_matrix(const mat4f &mat) {
     vec3f skew;
     vec4f perspective;
     glm::decompose<float>(mat, m_scale, m_orientation, m_position, skew, perspective);
-    m_transform_mat = mat;
-    m_transform_mat_ok = true;
-    m_inv_transform_mat_ok = false;
     return *this;
 }
 
-const mat4f &transform::matrix() const {
-    if(!m_transform_mat_ok) {
-        m_transform_mat = glm::translate(glm::mat4{1.F}, m_position);
-        m_transform_mat *= m_orientation.matrix();
-        m_transform_mat = glm::scale(m_transform_mat, m_scale);
-        m_transform_mat_ok = true;
-    }
+namespace {
+bool nearly_equal(float first, float second) {
+    return std::abs(first - second) <= EPS * std::max(std::abs(first), std::abs(second));
+}
+} // namespace
 
-    return m_transform_mat;
+bool transform::combines_exactly(const transform &parent, const transform &local) {
+    const auto &parent_scale = parent.m_scale;
+    const auto uniform_parent_scale = nearly_equal(parent_scale.x, parent_scale.y) && nearly_equal(parent_scale.y, parent_scale.z);
+    const auto local_unrotated = std::abs(local.m_orientation.w) >= 1.F - EPS;
+    return uniform_parent_scale || local_unrotated;
 }
 
-const mat4f &transform::inv_matrix() const {
-    if(!m_inv_transform_mat_ok) {
-        m_inv_transform_mat = matrix().inv();
-        m_inv_transform_mat_ok = true;
+transform &transform::set_combined(const transform &parent, const transform &local) {
+    if(!combines_exactly(parent, local)) {
+        return set_matrix(parent.matrix() * local.matrix());
     }
+    const auto &parent_scale = parent.m_scale;
+    m_position = parent.m_position + vec3f{parent.m_orientation * (parent_scale * local.m_position)};
+    m_orientation = parent.m_orientation * local.m_orientation;
+    m_scale = parent_scale * local.m_scale;
+    return *this;
+}
 
-    return m_inv_transform_mat;
+mat4f transform::matrix() const {
+    mat4f result = glm::translate(glm::mat4{1.F}, m_position);
+    result *= m_orientation.matrix();
+    return glm::scale(result, m_scale);
+}
+
+mat4f transform::inv_matrix() const {
+    // (T * R * S)^-1 = S^-1 * R^T * T^-1
+    const auto rotation_inv = glm::transpose(glm::mat3{m_orientation.matrix()});
+    glm::mat3 linear_inv;
+    for(int col = 0; col < 3; ++col) {
+        for(int row = 0; row < 3; ++row) {
+            linear_inv[col][row] = rotation_inv[col][row] / m_scale[row];
+        }
+    }
+    mat4f result = glm::mat4{linear_inv};
+    result[3] = glm::vec4{-(linear_inv * glm::vec3{m_position}), 1.F};
+    return result;
 }
 
 const quaternionf &transform::orientation() const {
@@ -150,4 +135,28 @@ const vec3f &transform::scale() const {
     return m_scale;
 }
 
-} // namespace st
\ No newline at end of file
+void compute_matrices(std::span<const transform *const> transforms, std::span<mat4f> out) {
+    assert(transforms.size() == out.size() && "Mismatched sizes");
+    // Small enough to live on the stack
+    constexpr std::size_t batch_size = 64;
+    std::array<vec3f, batch_size> positions;
+    std::array<quaternionf, batch_size> orientations;
+    std::array<vec3f, batch_size> scales;
+
+    for(std::size_t first = 0; first < transforms.size(); first += batch_size) {
+        const auto count = std::min(batch_size, transforms.size() - first);
+        for(std::size_t i = 0; i < count; ++i) {
+            const auto &tf = *transforms[first + i];
+            positions[i] = tf.position();
+            orientations[i] = tf.orientation();
+            scales[i] = tf.scale();
+        }
+        compose_trs(
+            std::span{positions}.first(count),
+            std::span{orientations}.first(count),
+            std::span{scales}.first(count),
+            out.subspan(first, count));
+    }
+}
+
+} // namespace st
@@ -1,5 +1,7 @@
 module;
 
+#include <span>
+
 export module stay3.core:transform;
 
 import :vector;
@@ -8,16 +10,22 @@ import :matrix;
 import :math;
 
 export namespace st {
+class transform;
+
 /**
- * @brief Translate-rotation-scale matrix with separate components
- * @note This class is not thread-safe
+ * @brief Writes `transforms[i]->matrix()` to `out[i]`, in batches with `compose_trs`
+ */
+void compute_matrices(std::span<const transform *const> transforms, std::span<mat4f> out);
+
+/**
+ * @brief Translate-rotation-scale with separate components
+ *
+ * Only position, orientation and scale are stored, matrices are computed when requested.
+ * Callers needing many matrices at once keep them in their own dense array, see `compute_matrices`
  */
 class transform {
 public:
     transform(const vec3f &position = {}, const quaternionf &orientation = {}, const vec3f &scale = vec3f{1.F});
-    transform(const transform &);
-    ~transform() = default;
-    transform &operator=(const transform &other);
     /**
      * @brief Rotates the transform around `axis` by `angle`
      * @param axis Rotation axis
@@ -34,10 +42,26 @@ public:
     transform &set_position(const vec3f &pos);
     transform &set_scale(const vec3f &scale);
     transform &set_scale(float scale);
+    /**
+     * @brief Decomposes `mat`, shear cannot be represented and is dropped
+     */
     transform &set_matrix(const mat4f &mat);
+    /**
+     * @brief Sets this to `local` expressed in the space of `parent`, the same as `set_matrix(parent.matrix() * local.matrix())`
+     *
+     * Positions, orientations and scales are composed directly unless the result has shear,
+     * then this is the closest transform without it
+     */
+    transform &set_combined(const transform &parent, const transform &local);
+    /**
+     * @brief Whether `set_combined(parent, local)` is exact
+     *
+     * The product only has shear when `parent` scales non-uniformly and `local` is rotated
+     */
+    [[nodiscard]] static bool combines_exactly(const transform &parent, const transform &local);
 
-    const mat4f &matrix() const;
-    const mat4f &inv_matrix() const;
+    [[nodiscard]] mat4f matrix() const;
+    [[nodiscard]] mat4f inv_matrix() const;
 
     const quaternionf &orientation() const;
     const vec3f &position() const;
@@ -47,11 +71,5 @@ private:
     vec3f m_position{0.F};
     quaternionf m_orientation;
     vec3f m_scale{1.F};
-
-    mutable mat4f m_transform_mat;
-    mutable mat4f m_inv_transform_mat;
-
-    mutable bool m_transform_mat_ok{false};
-    mutable bool m_inv_transform_mat_ok{false};
 };
 } // namespace st
\ No newline at end of file
@@ -0,0 +1,203 @@
+module;
+
+#include <cassert>
+#include <cstddef>
+#include <span>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <emmintrin.h>
+#    define STAY3_TRS_SSE
+#elif defined(__wasm_simd128__)
+#    include <wasm_simd128.h>
+#    define STAY3_TRS_WASM
+#endif
+
+export module stay3.core:trs_kernel;
+
+import :vector;
+import :quaternion;
+import :matrix;
+
+namespace st {
+
+#if defined(STAY3_TRS_SSE)
+using f32x4 = __m128;
+
+f32x4 splat(float value) {
+    return _mm_set1_ps(value);
+}
+f32x4 add(f32x4 lhs, f32x4 rhs) {
+    return _mm_add_ps(lhs, rhs);
+}
+f32x4 sub(f32x4 lhs, f32x4 rhs) {
+    return _mm_sub_ps(lhs, rhs);
+}
+f32x4 mul(f32x4 lhs, f32x4 rhs) {
+    return _mm_mul_ps(lhs, rhs);
+}
+f32x4 load(const float *data) {
+    return _mm_loadu_ps(data);
+}
+void store(float *data, f32x4 value) {
+    _mm_storeu_ps(data, value);
+}
+void transpose(f32x4 &row0, f32x4 &row1, f32x4 &row2, f32x4 &row3) {
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+}
+#elif defined(STAY3_TRS_WASM)
+using f32x4 = v128_t;
+
+f32x4 splat(float value) {
+    return wasm_f32x4_splat(value);
+}
+f32x4 add(f32x4 lhs, f32x4 rhs) {
+    return wasm_f32x4_add(lhs, rhs);
+}
+f32x4 sub(f32x4 lhs, f32x4 rhs) {
+    return wasm_f32x4_sub(lhs, rhs);
+}
+f32x4 mul(f32x4 lhs, f32x4 rhs) {
+    return wasm_f32x4_mul(lhs, rhs);
+}
+f32x4 load(const float *data) {
+    return wasm_v128_load(data);
+}
+void store(float *data, f32x4 value) {
+    wasm_v128_store(data, value);
+}
+void transpose(f32x4 &row0, f32x4 &row1, f32x4 &row2, f32x4 &row3) {
+    const auto low01 = wasm_i32x4_shuffle(row0, row1, 0, 4, 1, 5);
+    const auto low23 = wasm_i32x4_shuffle(row2, row3, 0, 4, 1, 5);
+    const auto high01 = wasm_i32x4_shuffle(row0, row1, 2, 6, 3, 7);
+    const auto high23 = wasm_i32x4_shuffle(row2, row3, 2, 6, 3, 7);
+    row0 = wasm_i32x4_shuffle(low01, low23, 0, 1, 4, 5);
+    row1 = wasm_i32x4_shuffle(low01, low23, 2, 3, 6, 7);
+    row2 = wasm_i32x4_shuffle(high01, high23, 0, 1, 4, 5);
+    row3 = wasm_i32x4_shuffle(high01, high23, 2, 3, 6, 7);
+}
+#endif
+
+#if defined(STAY3_TRS_SSE) || defined(STAY3_TRS_WASM)
+/**
+ * @brief Lanes hold the same component of 4 consecutive `vec3f`
+ */
+void load_components(const vec3f *values, f32x4 &x, f32x4 &y, f32x4 &z) {
+    alignas(16) float xs[4]{values[0].x, values[1].x, values[2].x, values[3].x};
+    alignas(16) float ys[4]{values[0].y, values[1].y, values[2].y, values[3].y};
+    alignas(16) float zs[4]{values[0].z, values[1].z, values[2].z, values[3].z};
+    x = load(xs);
+    y = load(ys);
+    z = load(zs);
+}
+
+/**
+ * @brief Composes 4 matrices with lanes of each register belonging to one transform
+ */
+void compose_trs_x4(const vec3f *positions, const quaternionf *orientations, const vec3f *scales, mat4f *out) {
+    static_assert(sizeof(quaternionf) == 4 * sizeof(float));
+    static_assert(sizeof(mat4f) == 16 * sizeof(float));
+    // glm stores quaternions as x, y, z, w
+    auto qx = load(&orientations[0].x);
+    auto qy = load(&orientations[1].x);
+    auto qz = load(&orientations[2].x);
+    auto qw = load(&orientations[3].x);
+    transpose(qx, qy, qz, qw);
+
+    f32x4 sx;
+    f32x4 sy;
+    f32x4 sz;
+    load_components(scales, sx, sy, sz);
+    f32x4 px;
+    f32x4 py;
+    f32x4 pz;
+    load_components(positions, px, py, pz);
+
+    const auto one = splat(1.F);
+    const auto two = splat(2.F);
+    const auto xx = mul(qx, qx);
+    const auto yy = mul(qy, qy);
+    const auto zz = mul(qz, qz);
+    const auto xy = mul(qx, qy);
+    const auto xz = mul(qx, qz);
+    const auto yz = mul(qy, qz);
+    const auto wx = mul(qw, qx);
+    const auto wy = mul(qw, qy);
+    const auto wz = mul(qw, qz);
+
+    // Rows of each register are columns of the resulting matrices, transposed back below
+    auto c0x = mul(sub(one, mul(two, add(yy, zz))), sx);
+    auto c0y = mul(mul(two, add(xy, wz)), sx);
+    auto c0z = mul(mul(two, sub(xz, wy)), sx);
+    auto c0w = splat(0.F);
+    auto c1x = mul(mul(two, sub(xy, wz)), sy);
+    auto c1y = mul(sub(one, mul(two, add(xx, zz))), sy);
+    auto c1z = mul(mul(two, add(yz, wx)), sy);
+    auto c1w = splat(0.F);
+    auto c2x = mul(mul(two, add(xz, wy)), sz);
+    auto c2y = mul(mul(two, sub(yz, wx)), sz);
+    auto c2z = mul(sub(one, mul(two, add(xx, yy))), sz);
+    auto c2w = splat(0.F);
+    auto c3w = one;
+    transpose(c0x, c0y, c0z, c0w);
+    transpose(c1x, c1y, c1z, c1w);
+    transpose(c2x, c2y, c2z, c2w);
+    transpose(px, py, pz, c3w);
+
+    const f32x4 columns[4][4]{
+        {c0x, c1x, c2x, px},
+        {c0y, c1y, c2y, py},
+        {c0z, c1z, c2z, pz},
+        {c0w, c1w, c2w, c3w},
+    };
+    for(std::size_t i = 0; i < 4; ++i) {
+        for(std::size_t col = 0; col < 4; ++col) {
+            store(&out[i][static_cast<int>(col)].x, columns[i][col]);
+        }
+    }
+}
+#endif
+
+export {
+    /**
+     * @brief Reference implementation of `compose_trs`, one matrix at a time
+     */
+    void compose_trs_scalar(std::span<const vec3f> positions, std::span<const quaternionf> orientations, std::span<const vec3f> scales, std::span<mat4f> out) {
+        assert(positions.size() == out.size() && orientations.size() == out.size() && scales.size() == out.size() && "Mismatched sizes");
+        for(std::size_t i = 0; i < out.size(); ++i) {
+            const auto &quat = orientations[i];
+            const auto xx = quat.x * quat.x;
+            const auto yy = quat.y * quat.y;
+            const auto zz = quat.z * quat.z;
+            const auto xy = quat.x * quat.y;
+            const auto xz = quat.x * quat.z;
+            const auto yz = quat.y * quat.z;
+            const auto wx = quat.w * quat.x;
+            const auto wy = quat.w * quat.y;
+            const auto wz = quat.w * quat.z;
+            const auto &scale = scales[i];
+            auto &result = out[i];
+            result[0] = {(1.F - (2.F * (yy + zz))) * scale.x, 2.F * (xy + wz) * scale.x, 2.F * (xz - wy) * scale.x, 0.F};
+            result[1] = {2.F * (xy - wz) * scale.y, (1.F - (2.F * (xx + zz))) * scale.y, 2.F * (yz + wx) * scale.y, 0.F};
+            result[2] = {2.F * (xz + wy) * scale.z, 2.F * (yz - wx) * scale.z, (1.F - (2.F * (xx + yy))) * scale.z, 0.F};
+            result[3] = {positions[i].x, positions[i].y, positions[i].z, 1.F};
+        }
+    }
+
+    /**
+     * @brief Writes `translate(position) * rotate(orientation) * scale(scale)` of every transform to `out`
+     *
+     * Same result as `transform::matrix`, 4 matrices at a time with SSE2 or WASM SIMD when available.
+     * Orientations are expected to be normalized
+     */
+    void compose_trs(std::span<const vec3f> positions, std::span<const quaternionf> orientations, std::span<const vec3f> scales, std::span<mat4f> out) {
+        assert(positions.size() == out.size() && orientations.size() == out.size() && scales.size() == out.size() && "Mismatched sizes");
+        std::size_t done = 0;
+#if defined(STAY3_TRS_SSE) || defined(STAY3_TRS_WASM)
+        for(; done + 4 <= out.size(); done += 4) {
+            compose_trs_x4(&positions[done], &orientations[done], &scales[done], &out[done]);
+        }
+#endif
+        compose_trs_scalar(positions.subspan(done), orientations.subspan(done), scales.subspan(done), out.subspan(done));
+    }
+}
+} // namespace st
@@ -0,0 +1,243 @@
+module;
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <entt/entt.hpp>
+
+export module stay3.ecs:change_tracker;
+
+import :entity;
+
+export namespace st {
+/**
+ * @brief Set of changed entities, replacement of per-frame tag components
+ *
+ * Marking and clearing do not touch the registry storage nor publish any signal
+ */
+class change_tracker {
+public:
+    /**
+     * @return Whether `en` was not marked before
+     */
+    bool mark(entity en) {
+        const auto index = to_index(en);
+        if(index >= m_sparse.size()) {
+            m_sparse.resize(index + 1, null_slot);
+        }
+        auto &slot = m_sparse[index];
+        if(slot != null_slot) {
+            if(m_dense[slot] == en) {
+                return false;
+            }
+            // Stale entry left by a destroyed entity with the same index
+            m_dense[slot] = en;
+            return true;
+        }
+        slot = static_cast<std::uint32_t>(m_dense.size());
+        m_dense.emplace_back(en);
+        return true;
+    }
+
+    /**
+     * @return Whether `en` was marked before
+     */
+    bool unmark(entity en) {
+        if(!contains(en)) {
+            return false;
+        }
+        const auto index = to_index(en);
+        const auto slot = m_sparse[index];
+        const auto last = m_dense.back();
+        m_dense[slot] = last;
+        m_sparse[to_index(last)] = slot;
+        m_sparse[index] = null_slot;
+        m_dense.pop_back();
+        return true;
+    }
+
+    [[nodiscard]] bool contains(entity en) const {
+        const auto index = to_index(en);
+        return index < m_sparse.size()
+               && m_sparse[index] != null_slot
+               && m_dense[m_sparse[index]] == en;
+    }
+
+    /**
+     * @brief Entities marked since last `clear`
+     * @note Invalidated by `mark`, `unmark`, `clear` and `sort`
+     */
+    [[nodiscard]] std::span<const entity> changed() const {
+        return m_dense;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return m_dense.size();
+    }
+
+    [[nodiscard]] bool is_empty() const {
+        return m_dense.empty();
+    }
+
+    void clear() {
+        for(auto en: m_dense) {
+            m_sparse[to_index(en)] = null_slot;
+        }
+        m_dense.clear();
+    }
+
+    template<typename pred>
+        requires std::is_invocable_r_v<bool, pred, entity, entity>
+    void sort(pred &&func) {
+        std::ranges::sort(m_dense, std::forward<pred>(func));
+        for(std::uint32_t slot = 0; slot < m_dense.size(); ++slot) {
+            m_sparse[to_index(m_dense[slot])] = slot;
+        }
+    }
+
+private:
+    static constexpr auto null_slot = std::numeric_limits<std::uint32_t>::max();
+
+    static std::size_t to_index(entity en) {
+        assert(!en.is_null() && "Null entity");
+        return static_cast<std::size_t>(entt::to_entity(static_cast<entt::entity>(en)));
+    }
+
+    std::vector<std::uint32_t> m_sparse;
+    std::vector<entity> m_dense;
+};
+
+/**
+ * @brief Append-only log of entities with a cursor per reader
+ *
+ * Entries every reader has consumed are trimmed. When the log outgrows the entities it lists, unread entries are
+ * moved into a deduplicated set per reader, so a reader that is watched but rarely read does not grow it forever
+ */
+class change_log {
+public:
+    using reader_id = std::uint64_t;
+
+    void record(entity en) {
+        if(m_readers.empty()) {
+            return;
+        }
+        // Repeated events of one entity are common, e.g. several writes in a row
+        if(!m_entries.empty() && static_cast<entt::entity>(m_entries.back()) == static_cast<entt::entity>(en)) {
+            return;
+        }
+        m_entries.emplace_back(en);
+        if(m_entries.size() >= m_compact_size) {
+            compact();
+        }
+    }
+
+    /**
+     * @brief Starts keeping entries for `id`, no-op if it is already a reader
+     */
+    void add_reader(reader_id id) {
+        find_or_add(id);
+    }
+
+    /**
+     * @brief Entities recorded since the previous `read` of `id` that satisfy `keep`, each listed once in order of first record
+     * @note Invalidated by the next `read` of `id`. Of an entity index reused before a compaction only the last entity is kept
+     */
+    template<typename pred>
+        requires std::is_invocable_r_v<bool, pred, entity>
+    std::span<const entity> read(reader_id id, pred &&keep) {
+        auto &current = find_or_add(id);
+        current.result.clear();
+        const auto end = m_trimmed + m_entries.size();
+        if(current.cursor == end && current.compacted.is_empty()) {
+            return {};
+        }
+        const auto collect = [this, &current, &keep](entity en) {
+            if(m_seen.mark(en) && keep(en)) {
+                current.result.push_back(en);
+            }
+        };
+        // Compacted entries were recorded before the ones still in the log
+        for(const auto en: current.compacted.changed()) {
+            collect(en);
+        }
+        current.compacted.clear();
+        for(auto i = current.cursor - m_trimmed; i < m_entries.size(); ++i) {
+            collect(m_entries[i]);
+        }
+        m_seen.clear();
+        current.cursor = end;
+        trim();
+        return current.result;
+    }
+
+    /**
+     * @brief Entries not consumed by every reader yet, without the ones compacted into readers' sets
+     */
+    [[nodiscard]] std::size_t size() const {
+        return m_entries.size();
+    }
+
+private:
+    struct reader {
+        reader_id id;
+        // Absolute position of the next entry to read
+        std::uint64_t cursor;
+        std::vector<entity> result;
+        // Unread entries moved out of the log, in order of first record
+        change_tracker compacted;
+    };
+
+    reader &find_or_add(reader_id id) {
+        const auto it = std::ranges::find(m_readers, id, &reader::id);
+        if(it != m_readers.end()) {
+            return *it;
+        }
+        // New readers see entries still kept for others
+        return m_readers.emplace_back(reader{.id = id, .cursor = m_trimmed, .result = {}, .compacted = {}});
+    }
+
+    void trim() {
+        const auto oldest = std::ranges::min(m_readers, {}, &reader::cursor).cursor;
+        const auto consumed = static_cast<std::size_t>(oldest - m_trimmed);
+        // Trimming halves at least, so erasing is amortized constant per entry
+        if(consumed == 0 || consumed * 2 < m_entries.size()) {
+            return;
+        }
+        m_entries.erase(m_entries.begin(), m_entries.begin() + static_cast<std::ptrdiff_t>(consumed));
+        m_trimmed = oldest;
+    }
+
+    /**
+     * @brief Moves the unread entries of every reader into its set and empties the log
+     *
+     * The next compaction waits until the log is twice the largest set, so each entry is moved once per reader
+     */
+    void compact() {
+        std::size_t largest{};
+        for(auto &current: m_readers) {
+            for(auto i = current.cursor - m_trimmed; i < m_entries.size(); ++i) {
+                current.compacted.mark(m_entries[i]);
+            }
+            current.cursor = m_trimmed + m_entries.size();
+            largest = std::max(largest, current.compacted.size());
+        }
+        m_trimmed += m_entries.size();
+        m_entries.clear();
+        m_compact_size = std::max(min_compact_size, 2 * largest);
+    }
+
+    static constexpr std::size_t min_compact_size = 4096;
+
+    std::vector<entity> m_entries;
+    std::size_t m_compact_size{min_compact_size};
+    std::uint64_t m_trimmed{};
+    std::vector<reader> m_readers;
+    change_tracker m_seen;
+};
+} // namespace st
@@ -0,0 +1,255 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <entt/entt.hpp>
+
+export module stay3.ecs:command_buffer;
+
+import :entity;
+import :component;
+import :ecs_registry;
+
+export namespace st {
+/**
+ * @brief Records structural changes to apply them later at a sync point with `playback`
+ *
+ * Recording is thread safe, every thread records to its own buffer.
+ * Playback creates entities first, then emplaces and removes components grouped by component type,
+ * in the order each thread recorded them, and finally destroys entities.
+ * Component commands on entities destroyed before playback are skipped,
+ * and emplacing a component the entity already has replaces it
+ * @note Recording must not happen concurrently with `playback`
+ */
+class ecs_command_buffer {
+    struct target;
+
+public:
+    /**
+     * @brief Handle to an entity which will be created by `playback`
+     */
+    class deferred_entity {
+    public:
+        deferred_entity() = default;
+
+    private:
+        friend class ecs_command_buffer;
+        deferred_entity(std::uint32_t recorder, std::uint32_t index)
+            : m_recorder{recorder}, m_index{index} {}
+        std::uint32_t m_recorder{};
+        std::uint32_t m_index{};
+    };
+
+    ecs_command_buffer(ecs_registry &reg)
+        : m_registry{reg} {}
+    ecs_command_buffer(const ecs_command_buffer &) = delete;
+    ecs_command_buffer(ecs_command_buffer &&) noexcept = delete;
+    ecs_command_buffer &operator=(const ecs_command_buffer &) = delete;
+    ecs_command_buffer &operator=(ecs_command_buffer &&) noexcept = delete;
+    ~ecs_command_buffer() = default;
+
+    [[nodiscard]] deferred_entity create() {
+        auto &rec = local_recorder();
+        return {rec.index, rec.create_count++};
+    }
+
+    void destroy_if_exist(entity en) {
+        local_recorder().destroyed.emplace_back(en);
+    }
+
+    template<component comp, typename... arguments>
+    void emplace(entity en, arguments &&...args) {
+        record_emplace<comp>(target{en}, std::forward<arguments>(args)...);
+    }
+
+    template<component comp, typename... arguments>
+    void emplace(deferred_entity en, arguments &&...args) {
+        record_emplace<comp>(target{en}, std::forward<arguments>(args)...);
+    }
+
+    template<component... comps>
+        requires(sizeof...(comps) > 0)
+    void destroy_if_exist(entity en) {
+        auto &rec = local_recorder();
+        (queue_at<std::decay_t<comps>>(rec.commands).commands.emplace_back(target{en}, std::nullopt), ...);
+    }
+
+    /**
+     * @brief Applies and clears recorded commands
+     */
+    void playback() {
+        auto &reg = m_registry.get();
+        for(auto &rec: m_recorders) {
+            rec->created.clear();
+            rec->created.reserve(rec->create_count);
+            for(std::uint32_t i = 0; i < rec->create_count; ++i) {
+                rec->created.emplace_back(reg.create());
+            }
+            rec->create_count = 0;
+        }
+        playback_queues();
+        for(auto &rec: m_recorders) {
+            for(auto en: rec->destroyed) {
+                reg.destroy_if_exist(en);
+            }
+            rec->destroyed.clear();
+        }
+    }
+
+    /**
+     * @return Entity created for `en` by the last `playback`
+     */
+    [[nodiscard]] entity resolve(deferred_entity en) const {
+        assert(en.m_recorder < m_recorders.size() && "Invalid deferred entity");
+        const auto &created = m_recorders[en.m_recorder]->created;
+        assert(en.m_index < created.size() && "Deferred entity was not played back");
+        return created[en.m_index];
+    }
+
+private:
+    struct target {
+        target(entity existing)
+            : en{existing} {}
+        target(deferred_entity created)
+            : deferred{created}, is_deferred{true} {}
+        entity en;
+        deferred_entity deferred;
+        bool is_deferred{};
+    };
+
+    struct command_queue {
+        command_queue() = default;
+        command_queue(const command_queue &) = delete;
+        command_queue(command_queue &&) noexcept = delete;
+        command_queue &operator=(const command_queue &) = delete;
+        command_queue &operator=(command_queue &&) noexcept = delete;
+        virtual ~command_queue() = default;
+        /**
+         * @brief Applies and clears the queue
+         */
+        virtual void playback(ecs_registry &reg, const ecs_command_buffer &buffer) = 0;
+    };
+
+    /**
+     * @brief Emplaces and removals of one component type in recorded order, a removal has no value
+     */
+    template<component comp>
+    struct component_queue: command_queue {
+        std::vector<std::pair<target, std::optional<comp>>> commands;
+        void playback(ecs_registry &reg, const ecs_command_buffer &buffer) override {
+            for(auto &[dst, value]: commands) {
+                const auto en = buffer.resolve(dst);
+                if(!reg.contains(en)) {
+                    continue;
+                }
+                if(!value.has_value()) {
+                    reg.destroy_if_exist<comp>(en);
+                } else if constexpr(std::is_empty_v<comp>) {
+                    reg.emplace_if_not_exist<comp>(en);
+                } else {
+                    reg.emplace_or_replace<comp>(en, std::move(*value));
+                }
+            }
+            commands.clear();
+        }
+    };
+
+    // Queues are indexed by `entt::type_index` of their component
+    using queue_list = std::vector<std::unique_ptr<command_queue>>;
+
+    struct recorder {
+        std::uint32_t index{};
+        std::thread::id owner;
+        std::uint32_t create_count{};
+        std::vector<entity> created;
+        queue_list commands;
+        std::vector<entity> destroyed;
+    };
+
+    template<component comp>
+    static component_queue<comp> &queue_at(queue_list &queues) {
+        const auto slot = entt::type_index<comp>::value();
+        if(slot >= queues.size()) {
+            queues.resize(slot + 1);
+        }
+        auto &result = queues[slot];
+        if(!result) {
+            result = std::make_unique<component_queue<comp>>();
+        }
+        return static_cast<component_queue<comp> &>(*result);
+    }
+
+    template<component comp, typename... arguments>
+    void record_emplace(target dst, arguments &&...args) {
+        using decayed = std::decay_t<comp>;
+        auto &rec = local_recorder();
+        queue_at<decayed>(rec.commands).commands.emplace_back(dst, decayed{std::forward<arguments>(args)...});
+    }
+
+    [[nodiscard]] entity resolve(const target &dst) const {
+        return dst.is_deferred ? resolve(dst.deferred) : dst.en;
+    }
+
+    /**
+     * @brief Plays back queues of all recorders ordered by component type so each storage is touched once
+     */
+    void playback_queues() {
+        std::size_t slot_count{};
+        for(const auto &rec: m_recorders) {
+            slot_count = std::max(slot_count, rec->commands.size());
+        }
+        for(std::size_t slot = 0; slot < slot_count; ++slot) {
+            for(auto &rec: m_recorders) {
+                auto &list = rec->commands;
+                if(slot < list.size() && list[slot]) {
+                    list[slot]->playback(m_registry.get(), *this);
+                }
+            }
+        }
+    }
+
+    recorder &local_recorder() {
+        // Caches the recorder of the last buffer used by this thread
+        thread_local struct {
+            std::uint64_t buffer_id{};
+            recorder *rec{};
+        } cache;
+        if(cache.buffer_id == m_id) {
+            return *cache.rec;
+        }
+        const std::scoped_lock lock{m_mutex};
+        const auto thread_id = std::this_thread::get_id();
+        auto it = std::ranges::find(m_recorders, thread_id, [](const auto &rec) { return rec->owner; });
+        if(it == m_recorders.end()) {
+            auto &rec = *m_recorders.emplace_back(std::make_unique<recorder>());
+            rec.index = static_cast<std::uint32_t>(m_recorders.size() - 1);
+            rec.owner = thread_id;
+            it = std::prev(m_recorders.end());
+        }
+        cache = {.buffer_id = m_id, .rec = it->get()};
+        return *cache.rec;
+    }
+
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> counter{};
+        return ++counter;
+    }
+
+    std::reference_wrapper<ecs_registry> m_registry;
+    const std::uint64_t m_id{next_id()};
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<recorder>> m_recorders;
+};
+} // namespace st
@@ -9,8 +9,53 @@ import :entity;
 
 export namespace st {
 
+enum class comp_event : std::uint8_t {
+    construct,
+    destroy,
+    update,
+};
+
+/**
+ * @brief Reactive filter of entities whose `comp` was constructed
+ */
+template<typename comp>
+struct added {};
+/**
+ * @brief Reactive filter of entities whose `comp` was constructed or updated
+ */
+template<typename comp>
+struct changed {};
+/**
+ * @brief Reactive filter of entities whose `comp` was destroyed
+ */
+template<typename comp>
+struct removed {};
+
 template<typename type>
-concept component = !std::is_same_v<entity, std::decay_t<type>>;
+struct reactive_filter_traits {
+    static constexpr bool is_filter = false;
+};
+template<typename comp>
+struct reactive_filter_traits<added<comp>> {
+    static constexpr bool is_filter = true;
+    using component_type = comp;
+};
+template<typename comp>
+struct reactive_filter_traits<changed<comp>> {
+    static constexpr bool is_filter = true;
+    using component_type = comp;
+};
+template<typename comp>
+struct reactive_filter_traits<removed<comp>> {
+    static constexpr bool is_filter = true;
+    using component_type = comp;
+};
+
+template<typename type>
+concept reactive_filter = reactive_filter_traits<std::decay_t<type>>::is_filter;
+
+template<typename type>
+concept component = !std::is_same_v<entity, std::decay_t<type>> && !reactive_filter<type>;
 
 template<typename func, typename comp>
 concept is_sort_predicate =
@@ -20,10 +65,4 @@ concept is_sort_predicate =
         const std::decay_t<comp> &,
         const std::decay_t<comp> &>;
 
-enum class comp_event : std::uint8_t {
-    construct,
-    destroy,
-    update,
-};
-
 } // namespace st
\ No newline at end of file
@@ -1,6 +1,8 @@
 module;
 
 #include <cassert>
+#include <cstdint>
+#include <type_traits>
 
 export module stay3.ecs:component_ref;
 
@@ -11,6 +13,10 @@ import :component;
 export namespace st {
 /**
  * @brief Alternative to reference the component from its entity
+ *
+ * The component address is cached together with `ecs_registry::storage_version`,
+ * so repeated access is a pointer dereference until the storage changes
+ * @note Not safe to `get` the same reference from several threads at once
  */
 template<component comps>
 class component_ref {
@@ -21,6 +27,7 @@ public:
         : m_entity{en} {}
     component_ref &operator=(entity en) {
         m_entity = en;
+        m_cache = {};
         return *this;
     }
     /**
@@ -28,14 +35,22 @@ public:
      */
     [[nodiscard]] auto get(ecs_registry &reg) const {
         assert(!m_entity.is_null() && "Null component reference");
-        return reg.get<comps>(m_entity);
+        if constexpr(std::is_empty_v<comps>) {
+            return reg.get<comps>(m_entity);
+        } else {
+            return ecs_registry::proxy<comps>{resolve(reg)};
+        }
     }
     /**
      * @return Write access proxy to the component
      */
     [[nodiscard]] auto get_mut(ecs_registry &reg) const {
         assert(!m_entity.is_null() && "Null component reference");
-        return reg.get<add_mut_t<comps>>(m_entity);
+        if constexpr(std::is_empty_v<comps>) {
+            return reg.get<add_mut_t<comps>>(m_entity);
+        } else {
+            return ecs_registry::proxy<add_mut_t<comps>>{reg, m_entity, resolve(reg)};
+        }
     }
     [[nodiscard]] entity entity() const {
         return m_entity;
@@ -51,6 +66,29 @@ public:
     }
 
 private:
+    struct cache {
+        const ecs_registry *registry{};
+        std::uint64_t version{};
+        comps *component{};
+    };
+
+    comps &resolve(ecs_registry &reg) const {
+        const auto version = reg.storage_version<comps>();
+        const auto is_valid = m_cache.component != nullptr
+                              && m_cache.registry == &reg
+                              && m_cache.version == version
+                              && version != ecs_registry::unstable_storage;
+        if(!is_valid) {
+            m_cache = {
+                .registry = &reg,
+                .version = version,
+                .component = &reg.m_registry.get<comps>(m_entity),
+            };
+        }
+        return *m_cache.component;
+    }
+
     struct entity m_entity;
+    mutable cache m_cache;
 };
-} // namespace st
\ No newline at end of file
+} // namespace st
@@ -1,11 +1,19 @@
 module;
 
+#include <cassert>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <ranges>
+#include <span>
+#include <tuple>
 #include <type_traits>
-#include <typeindex>
 #include <utility>
+#include <vector>
 #include <entt/entt.hpp>
 
 export module stay3.ecs:ecs_registry;
@@ -13,6 +21,7 @@ export module stay3.ecs:ecs_registry;
 import stay3.core;
 import :entity;
 import :component;
+import :change_tracker;
 
 export namespace st {
 
@@ -49,6 +58,19 @@ struct exclude_t {};
 template<typename... ts>
 constexpr exclude_t<ts...> exclude{};
 
+template<typename... ts>
+struct get_t {};
+/**
+ * @brief Non-owned components of a `group`
+ */
+template<typename... ts>
+constexpr get_t<ts...> get{};
+
+class ecs_snapshot;
+class ecs_snapshot_loader;
+template<component comps>
+class component_ref;
+
 class ecs_registry {
     template<component ecomp>
     class empty_proxy {
@@ -85,6 +107,8 @@ class ecs_registry {
     public:
         write_access_proxy(ecs_registry &reg, entity en)
             : m_registry{&reg}, m_entity{en}, m_component{&reg.m_registry.get<comp>(en)} {}
+        write_access_proxy(ecs_registry &reg, entity en, comp &data)
+            : m_registry{&reg}, m_entity{en}, m_component{&data} {}
         ~write_access_proxy() {
             publish_update_event();
         }
@@ -142,6 +166,59 @@ class ecs_registry {
         }
     }
 
+    /**
+     * @brief Same as above but reads the component through `source`, an EnTT view or group
+     */
+    template<component comp, typename source>
+    proxy<comp> make_proxy(source &src, entity en) {
+        if constexpr(is_mut_v<comp>) {
+            return write_access_proxy<comp>{*this, en, src.template get<remove_mut_t<comp>>(en)};
+        } else if constexpr(std::is_empty_v<comp>) {
+            return {};
+        } else {
+            return src.template get<std::decay_t<comp>>(en);
+        }
+    }
+
+    /**
+     * @brief Write proxy used by `par_each`, its update event is published after the parallel loop
+     */
+    template<typename comp>
+    class deferred_write_proxy {};
+    template<component comp>
+    class deferred_write_proxy<mut<comp>> {
+    public:
+        deferred_write_proxy(comp &data)
+            : m_component{&data} {}
+
+        comp *operator->() const {
+            return m_component;
+        }
+        comp &operator*() const {
+            return *m_component;
+        }
+
+    private:
+        comp *m_component;
+    };
+
+    template<component comp>
+    using parallel_proxy = std::conditional_t<is_mut_v<comp>, deferred_write_proxy<comp>, proxy<comp>>;
+
+    /**
+     * @brief Only touches `view`, so it is safe to call from worker threads
+     */
+    template<component comp, typename entt_view>
+    static parallel_proxy<comp> make_parallel_proxy(entt_view &view, entity en) {
+        if constexpr(is_mut_v<comp>) {
+            return {view.template get<remove_mut_t<comp>>(en)};
+        } else if constexpr(std::is_empty_v<comp>) {
+            return {};
+        } else {
+            return {view.template get<comp>(en)};
+        }
+    }
+
     template<typename entt_it, component... comps>
     class entity_components_view_iterator {
     public:
@@ -197,6 +274,73 @@ class ecs_registry {
         std::reference_wrapper<ecs_registry> m_registry;
     };
 
+    template<typename entt_group, component... comps>
+    class entity_components_group_iterator {
+    public:
+        using entt_it = std::decay_t<decltype(std::declval<entt_group>().begin())>;
+        using difference_type = entt_it::difference_type;
+        using value_type = std::tuple<entity, proxy<comps>...>;
+        entity_components_group_iterator(entt_it it = {}, entt_group group = {}, ecs_registry *reg = nullptr)
+            : m_it{it}, m_group{group}, m_registry{reg} {}
+        value_type operator*() const {
+            assert(m_registry != nullptr);
+            entity en{*m_it};
+            return {en, m_registry->make_proxy<comps>(m_group, en)...};
+        }
+        entity_components_group_iterator &operator++() {
+            ++m_it;
+            return *this;
+        }
+        bool operator==(const entity_components_group_iterator &other) const {
+            return m_it == other.m_it;
+        }
+        void operator++(int) {
+            ++*this;
+        }
+
+    private:
+        entt_it m_it;
+        // Groups are lightweight handles
+        mutable entt_group m_group;
+        ecs_registry *m_registry;
+    };
+
+    template<typename entt_group, component... comps>
+    class entity_components_group {
+    public:
+        using iterator = entity_components_group_iterator<entt_group, comps...>;
+        static_assert(std::input_iterator<iterator>);
+        static_assert(std::semiregular<iterator>);
+        static_assert(std::sentinel_for<iterator, iterator>);
+
+        entity_components_group(entt_group group, ecs_registry &reg)
+            : m_group{group}, m_registry{reg} {}
+        iterator begin() {
+            return {m_group.begin(), m_group, &m_registry.get()};
+        }
+        auto front() {
+            assert(m_group.begin() != m_group.end() && "No entity with matching components");
+            return *begin();
+        }
+        iterator end() {
+            return {m_group.end(), m_group, &m_registry.get()};
+        }
+        [[nodiscard]] std::size_t size() const {
+            return m_group.size();
+        }
+        /**
+         * @brief Proxies to components of `en`, which must be in the group
+         */
+        auto get(entity en) {
+            assert(m_group.contains(en) && "Entity is not in the group");
+            return std::tuple<proxy<comps>...>{m_registry.get().template make_proxy<comps>(m_group, en)...};
+        }
+
+    private:
+        entt_group m_group;
+        std::reference_wrapper<ecs_registry> m_registry;
+    };
+
     template<typename entt_it, component... comps>
     class entity_view_iterator {
     public:
@@ -248,6 +392,42 @@ class ecs_registry {
         entt_view m_view;
     };
 
+    template<comp_event ev, component... comps>
+        requires(ev != comp_event::destroy)
+    class event_batch {
+    public:
+        event_batch(ecs_registry &reg)
+            : m_registry{&reg} {
+            (m_registry->begin_batch<ev, comps>(), ...);
+        }
+        ~event_batch() {
+            flush();
+        }
+        event_batch(const event_batch &) = delete;
+        event_batch(event_batch &&other) noexcept
+            : m_registry{other.m_registry} {
+            other.m_registry = nullptr;
+        }
+        event_batch &operator=(const event_batch &) = delete;
+        event_batch &operator=(event_batch &&) noexcept = delete;
+
+    private:
+        void flush() noexcept {
+            try {
+                if(m_registry != nullptr) {
+                    (m_registry->end_batch<ev, comps>(), ...);
+                }
+            } catch(std::exception &e) {
+                log::error("Error at component event listener: ", e.what());
+                assert(false);
+            } catch(...) {
+                assert(false && "Unknown error");
+            }
+        }
+
+        ecs_registry *m_registry;
+    };
+
 public:
     ecs_registry() {
         m_registry.on_destroy<entt::entity>().connect<&ecs_registry::entity_destroyed_handler>(*this);
@@ -257,10 +437,24 @@ public:
         return m_registry.create();
     }
 
+    /**
+     * @brief Fills `entities` with new entities
+     */
+    void create(std::span<entity> entities) {
+        m_registry.create(entities.begin(), entities.end());
+    }
+
     void destroy(entity en) {
         m_registry.destroy(en);
     }
 
+    /**
+     * @brief Destroys valid and unique `entities` at once, components of a type are removed together
+     */
+    void destroy(std::span<const entity> entities) {
+        m_registry.destroy(entities.begin(), entities.end());
+    }
+
     void destroy_if_exist(entity en) {
         if(m_registry.valid(en)) {
             m_registry.destroy(en);
@@ -280,6 +474,20 @@ public:
         return get<comp>(en);
     }
 
+    /**
+     * @brief Emplaces copies of `value` to `entities` without the component, reserving storage once
+     *
+     * Construct events are published in one batch after all components are emplaced
+     */
+    template<component comp>
+    void insert(std::span<const entity> entities, const std::decay_t<remove_mut_t<comp>> &value = {}) {
+        using raw_comp = std::decay_t<remove_mut_t<comp>>;
+        auto scope = batch<comp_event::construct, raw_comp>();
+        auto &storage = m_registry.storage<raw_comp>();
+        storage.reserve(storage.size() + entities.size());
+        m_registry.insert<raw_comp>(entities.begin(), entities.end(), value);
+    }
+
     template<component comp, typename... arguments>
     proxy<comp> emplace_or_replace(entity en, arguments &&...args) {
         m_registry.emplace_or_replace<std::decay_t<remove_mut_t<comp>>>(en, std::forward<arguments>(args)...);
@@ -310,6 +518,32 @@ public:
         m_registry.clear<comp>();
     }
 
+    /**
+     * @brief Whether no entity has `comp`, without looking up any entity
+     */
+    template<component comp>
+    [[nodiscard]] bool is_empty() {
+        return m_registry.storage<std::decay_t<remove_mut_t<comp>>>().empty();
+    }
+
+    /**
+     * @brief Prepares `comp` for lookups from several threads, false if accessing it there is not thread safe
+     *
+     * Creates the storage of `comp`, so later lookups do not insert into the registry.
+     * A `mut<comp>` is only safe without update listeners, since its proxies publish them on the writing thread
+     */
+    template<component comp>
+    [[nodiscard]] bool prepare_concurrent_access() {
+        using raw_comp = std::decay_t<remove_mut_t<comp>>;
+        static_cast<void>(m_registry.storage<raw_comp>());
+        if constexpr(is_mut_v<comp>) {
+            const auto *found = find_signals<comp_event::update, raw_comp>();
+            return found == nullptr || (found->sig.empty() && found->batch_sig.empty() && found->batch_depth == 0);
+        } else {
+            return true;
+        }
+    }
+
     template<component comp, typename func>
         requires std::invocable<func, comp &>
     void patch(entity en, func &&patcher) {
@@ -358,6 +592,102 @@ public:
         return result{m_registry.view<remove_mut_t<comps>...>(entt::exclude<exclude_comps...>), *this};
     }
 
+    /**
+     * @brief Parallel version of `each`, calls `fn(en, proxies...)` for matching entities on `pool`
+     *
+     * `fn` may only access the listed components of the entity it receives and must not
+     * create or destroy entities or components. Update events of `mut` components are published
+     * on the calling thread after the loop, inside one `batch` per component type
+     * @example
+     * ```
+     * registry.par_each<mut<comp1>, comp2>([](entity en, auto c1, auto c2) {
+     *     // Access components here...
+     * });
+     * ```
+     */
+    template<component... comps, typename func, component... exclude_comps>
+        requires(sizeof...(comps) > 0) && std::invocable<func &, entity, parallel_proxy<comps>...>
+    void par_each(thread_pool &pool, func &&fn, exclude_t<exclude_comps...> = {}) {
+        auto view = m_registry.view<remove_mut_t<comps>...>(entt::exclude<exclude_comps...>);
+        const auto *leading = view.handle();
+        assert(leading != nullptr && "View without storage");
+        const auto count = leading->size();
+        const auto grain = pool.default_grain(count);
+        std::vector<std::vector<entity>> touched;
+        if constexpr((is_mut_v<comps> || ...)) {
+            touched.resize((count + grain - 1) / grain);
+        }
+        pool.parallel_for(count, grain, [&](std::size_t begin, std::size_t end) {
+            for(auto i = begin; i < end; ++i) {
+                const auto raw = leading->data()[i];
+                if(!view.contains(raw)) {
+                    continue;
+                }
+                const entity en{raw};
+                fn(en, make_parallel_proxy<comps>(view, en)...);
+                if constexpr((is_mut_v<comps> || ...)) {
+                    touched[begin / grain].emplace_back(en);
+                }
+            }
+        });
+        publish_deferred_updates<comps...>(touched);
+    }
+
+    template<component... comps, typename func, component... exclude_comps>
+        requires(sizeof...(comps) > 0) && std::invocable<func &, entity, parallel_proxy<comps>...>
+    void par_each(func &&fn, exclude_t<exclude_comps...> excluded = {}) {
+        par_each<comps...>(default_thread_pool(), std::forward<func>(fn), excluded);
+    }
+
+    /**
+     * @brief Same as above but iterates `entities`, each of them must have all of `comps`
+     */
+    template<component... comps, typename func>
+        requires(sizeof...(comps) > 0) && std::invocable<func &, entity, parallel_proxy<comps>...>
+    void par_each(thread_pool &pool, std::span<const entity> entities, func &&fn) {
+        auto view = m_registry.view<remove_mut_t<comps>...>();
+        const auto grain = pool.default_grain(entities.size());
+        std::vector<std::vector<entity>> touched;
+        if constexpr((is_mut_v<comps> || ...)) {
+            touched.resize((entities.size() + grain - 1) / grain);
+        }
+        pool.parallel_for(entities.size(), grain, [&](std::size_t begin, std::size_t end) {
+            if constexpr((is_mut_v<comps> || ...)) {
+                touched[begin / grain].assign(entities.begin() + begin, entities.begin() + end);
+            }
+            for(auto i = begin; i < end; ++i) {
+                assert(view.contains(entities[i]) && "Entity does not have required components");
+                fn(entities[i], make_parallel_proxy<comps>(view, entities[i])...);
+            }
+        });
+        publish_deferred_updates<comps...>(touched);
+    }
+
+    /**
+     * @brief Same as `each`, but iterates an EnTT group which keeps `owned` components packed
+     * in the same order, so they are accessed sequentially
+     *
+     * Owned components cannot be owned by another group nor sorted with `sort`
+     * @example
+     * ```
+     * for (auto &&[en, c1, c2, c3] : registry.group<mut<comp1>, comp2>(get<comp3>)) {
+     *     // Access components here...
+     * }
+     * ```
+     */
+    template<component... owned, component... get_comps, component... exclude_comps>
+        requires(sizeof...(owned) + sizeof...(get_comps) > 0)
+    auto group(get_t<get_comps...> = {}, exclude_t<exclude_comps...> = {}) {
+        using entt_group = std::decay_t<decltype(std::declval<entt::registry>()
+                                                     .group<remove_mut_t<owned>...>(
+                                                         std::declval<entt::get_t<remove_mut_t<get_comps>...>>(),
+                                                         std::declval<entt::exclude_t<exclude_comps...>>()))>;
+        using result = entity_components_group<entt_group, owned..., get_comps...>;
+        static_assert(std::ranges::range<result>);
+        (mark_owned<remove_mut_t<owned>>(), ...);
+        return result{m_registry.group<remove_mut_t<owned>...>(entt::get<remove_mut_t<get_comps>...>, entt::exclude<exclude_comps...>), *this};
+    }
+
     template<component... comps, component... exclude_comps>
     auto view(exclude_t<exclude_comps...> = {}) {
         using entt_view = std::decay_t<decltype(std::declval<entt::registry>()
@@ -371,19 +701,126 @@ public:
         requires is_sort_predicate<pred, comp>
     void sort(pred &&func) {
         m_registry.sort<comp>(std::forward<pred>(func));
+        bump_storage_version<comp>(m_registry, {});
     }
 
+    /**
+     * @brief Counter that changes whenever components of type `comp` may have moved in memory
+     *
+     * Components move when one of them is removed, when they are sorted and, if they are owned by a group,
+     * whenever the group changes. Owned components report `unstable_storage` instead
+     */
+    template<component comp>
+    [[nodiscard]] std::uint64_t storage_version() {
+        const auto slot = entt::type_index<std::decay_t<comp>>::value();
+        if(slot >= m_storage_versions.size()) {
+            m_storage_versions.resize(slot + 1);
+        }
+        auto &version = m_storage_versions[slot];
+        if(version == 0) {
+            m_registry.on_destroy<std::decay_t<comp>>().template connect<&ecs_registry::bump_storage_version<comp>>(*this);
+            version = 1;
+        }
+        return version;
+    }
+    static constexpr auto unstable_storage = std::numeric_limits<std::uint64_t>::max();
+
     void clear() {
         m_registry.clear();
+        for(auto &changes: m_trackers) {
+            if(changes) {
+                changes->clear();
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the change tracker identified by `tag`
+     * @note Destroyed entities are removed from all trackers
+     */
+    template<typename tag>
+    [[nodiscard]] change_tracker &tracker() {
+        const auto slot = entt::type_index<tag>::value();
+        if(slot >= m_trackers.size()) {
+            m_trackers.resize(slot + 1);
+        }
+        auto &changes = m_trackers[slot];
+        if(!changes) {
+            changes = std::make_unique<change_tracker>();
+        }
+        return *changes;
+    }
+
+    /**
+     * @brief Entities matching `filter` since the previous call by `reader`, each listed once
+     *
+     * `filter` is `added<comp>`, `changed<comp>` or `removed<comp>`. Events are only recorded while
+     * the filter has readers, see `watch`. `added` and `changed` skip entities that lost `comp` since.
+     * Nothing is iterated when nothing happened
+     * @note Invalidated by the next call with the same `reader`
+     * @example
+     * ```
+     * for (auto en : registry.each<changed<comp1>, my_system>()) {
+     *     // React to the change here...
+     * }
+     * ```
+     */
+    template<reactive_filter filter, typename reader = filter>
+    [[nodiscard]] std::span<const entity> each() {
+        using comp = reactive_filter_traits<filter>::component_type;
+        const auto id = entt::type_hash<reader>::value();
+        if constexpr(std::is_same_v<filter, removed<comp>>) {
+            return change_log_of<filter>().read(id, [](entity) { return true; });
+        } else {
+            return change_log_of<filter>().read(id, [this](entity en) {
+                return m_registry.valid(en) && m_registry.all_of<std::decay_t<comp>>(en);
+            });
+        }
+    }
+
+    /**
+     * @brief Starts recording events of `filter` for `reader`, call it before the events to observe
+     */
+    template<reactive_filter filter, typename reader = filter>
+    void watch() {
+        change_log_of<filter>().add_reader(entt::type_hash<reader>::value());
     }
 
     template<comp_event ev, component comp>
     decltype(auto) on() {
-        const auto key = event_key<ev, comp>;
-        if(!m_component_signals.contains(key)) {
-            create_event<ev, comp>();
-        }
-        return m_component_signals[key].sk;
+        return signals<ev, comp>().sk;
+    }
+
+    /**
+     * @brief Same as `on`, but listeners receive entities in spans
+     *
+     * Outside of a `batch` scope every event is delivered as a span of one entity
+     */
+    template<comp_event ev, component comp>
+    decltype(auto) on_batch() {
+        return signals<ev, comp>().batch_sk;
+    }
+
+    /**
+     * @brief Defers `ev` events of `comps` until the returned scope is destroyed
+     *
+     * Each entity is reported at most once per component type. At the end of the scope,
+     * `on` listeners are called per entity and `on_batch` listeners once with all entities.
+     * Destroy events cannot be deferred, listeners expect the component to still exist
+     * @example
+     * ```
+     * {
+     *     auto scope = registry.batch<comp_event::update, comp1>();
+     *     for (auto &&[en, c1] : registry.each<mut<comp1>>()) {
+     *         // Modify components here...
+     *     }
+     * } // Events are published here
+     * ```
+     */
+    template<comp_event ev, component... comps>
+        requires(sizeof...(comps) > 0 && ev != comp_event::destroy)
+    [[nodiscard]] event_batch<ev, comps...> batch() {
+        return event_batch<ev, comps...>{*this};
     }
 
     decltype(auto) on_entity_destroyed() {
@@ -391,8 +828,83 @@ public:
     }
 
 private:
+    friend class ecs_snapshot;
+    friend class ecs_snapshot_loader;
+    template<component comps>
+    friend class component_ref;
+    struct signal_pair;
+
+    template<component comp>
+    void bump_storage_version(entt::registry &, entt::entity) {
+        const auto slot = entt::type_index<std::decay_t<comp>>::value();
+        if(slot < m_storage_versions.size() && m_storage_versions[slot] != 0 && m_storage_versions[slot] != unstable_storage) {
+            ++m_storage_versions[slot];
+        }
+    }
+
+    template<reactive_filter filter>
+    change_log &change_log_of() {
+        using comp = reactive_filter_traits<filter>::component_type;
+        constexpr std::size_t filter_kinds = 3;
+        std::size_t kind = 0;
+        if constexpr(std::is_same_v<filter, changed<comp>>) {
+            kind = 1;
+        } else if constexpr(std::is_same_v<filter, removed<comp>>) {
+            kind = 2;
+        }
+        const auto slot = (entt::type_index<std::decay_t<comp>>::value() * filter_kinds) + kind;
+        if(slot >= m_change_logs.size()) {
+            m_change_logs.resize(slot + 1);
+        }
+        auto &log = m_change_logs[slot];
+        if(!log) {
+            log = std::make_unique<change_log>();
+            if constexpr(std::is_same_v<filter, removed<comp>>) {
+                on<comp_event::destroy, comp>().template connect<&change_log::record>(*log);
+            } else {
+                on<comp_event::construct, comp>().template connect<&change_log::record>(*log);
+                if constexpr(std::is_same_v<filter, changed<comp>>) {
+                    on<comp_event::update, comp>().template connect<&change_log::record>(*log);
+                }
+            }
+        }
+        return *log;
+    }
+
+    template<component comp>
+    void mark_owned() {
+        const auto slot = entt::type_index<std::decay_t<comp>>::value();
+        if(slot >= m_storage_versions.size()) {
+            m_storage_versions.resize(slot + 1);
+        }
+        m_storage_versions[slot] = unstable_storage;
+    }
+
+    /**
+     * @brief Index of the signals of `ev` for `comp` in `m_component_signals`
+     */
     template<comp_event ev, component comp>
-    void create_event() {
+    static std::size_t event_slot() {
+        return (entt::type_index<std::decay_t<comp>>::value() * comp_event_count) + static_cast<std::size_t>(ev);
+    }
+
+    template<comp_event ev, component comp>
+    signal_pair *find_signals() {
+        const auto slot = event_slot<ev, comp>();
+        return slot < m_component_signals.size() ? m_component_signals[slot].get() : nullptr;
+    }
+
+    template<comp_event ev, component comp>
+    signal_pair &signals() {
+        auto *entry = find_signals<ev, comp>();
+        if(entry == nullptr) {
+            entry = &create_event<ev, comp>();
+        }
+        return *entry;
+    }
+
+    template<comp_event ev, component comp>
+    signal_pair &create_event() {
         using decayed = std::decay_t<comp>;
         auto entt_sink = m_registry.on_construct<decayed>();
         if constexpr(ev == comp_event::destroy) {
@@ -402,52 +914,134 @@ private:
             entt_sink = m_registry.on_update<decayed>();
         }
 
-        m_component_signals.try_emplace(event_key<ev, comp>);
+        const auto slot = event_slot<ev, comp>();
+        if(slot >= m_component_signals.size()) {
+            m_component_signals.resize(slot + 1);
+        }
+        auto &entry = *(m_component_signals[slot] = std::make_unique<signal_pair>());
         entt_sink.template connect<&ecs_registry::publish_event<ev, comp>>(*this);
+        return entry;
     }
 
     /**
-     * @brief Helper to publish an event if it was observed by `on`
+     * @brief Helper to publish an event if it was observed by `on` or `on_batch`
      */
     template<comp_event ev, component comp>
     void publish_event(entt::registry &, entity en) {
-        if(!m_component_signals.contains(event_key<ev, comp>)) {
+        auto *found = find_signals<ev, comp>();
+        if(found == nullptr) {
+            return;
+        }
+        auto &entry = *found;
+        if(entry.batch_depth > 0) {
+            entry.batched.mark(en);
             return;
         }
-        m_component_signals[event_key<ev, comp>].sig.publish(*this, en);
+        entry.sig.publish(*this, en);
+        entry.batch_sig.publish(*this, std::span<const entity>{&en, 1});
+    }
+
+    /**
+     * @brief Publishes update events of the `mut` components touched by `par_each` chunks, in chunk order
+     */
+    template<component... comps>
+    void publish_deferred_updates(std::span<const std::vector<entity>> touched) {
+        if constexpr((is_mut_v<comps> || ...)) {
+            (begin_deferred_updates<comps>(), ...);
+            for(const auto &chunk: touched) {
+                for(auto en: chunk) {
+                    (publish_deferred_update<comps>(en), ...);
+                }
+            }
+            (end_deferred_updates<comps>(), ...);
+        }
+    }
+
+    template<component comp>
+    void begin_deferred_updates() {
+        if constexpr(is_mut_v<comp>) {
+            begin_batch<comp_event::update, remove_mut_t<comp>>();
+        }
+    }
+
+    template<component comp>
+    void publish_deferred_update(entity en) {
+        if constexpr(is_mut_v<comp>) {
+            publish_event<comp_event::update, remove_mut_t<comp>>(m_registry, en);
+        }
+    }
+
+    template<component comp>
+    void end_deferred_updates() {
+        if constexpr(is_mut_v<comp>) {
+            end_batch<comp_event::update, remove_mut_t<comp>>();
+        }
+    }
+
+    template<comp_event ev, component comp>
+        requires(ev != comp_event::destroy)
+    void begin_batch() {
+        ++signals<ev, comp>().batch_depth;
+    }
+
+    template<comp_event ev, component comp>
+        requires(ev != comp_event::destroy)
+    void end_batch() {
+        using decayed = std::decay_t<comp>;
+        auto &entry = signals<ev, comp>();
+        assert(entry.batch_depth > 0 && "Unbalanced event batch");
+        if(--entry.batch_depth > 0) {
+            return;
+        }
+        // Listeners may start new batches of the same event
+        const auto pending = entry.batched.changed();
+        std::vector<entity> batched{pending.begin(), pending.end()};
+        entry.batched.clear();
+        // Entities might lose the component before the batch ends
+        std::erase_if(batched, [this](entity en) {
+            return !m_registry.valid(en) || !m_registry.all_of<decayed>(en);
+        });
+        if(batched.empty()) {
+            return;
+        }
+        for(auto en: batched) {
+            entry.sig.publish(*this, en);
+        }
+        entry.batch_sig.publish(*this, std::span<const entity>{batched});
     }
 
-    struct component_event {
-        comp_event first;
-        std::type_index second;
-    };
     using signal_signature = void(ecs_registry &, entity);
+    using batch_signal_signature = void(ecs_registry &, std::span<const entity>);
     struct signal_pair {
         signal<signal_signature> sig;
         sink<decltype(sig)> sk{sig};
-    };
-    struct hasher {
-        std::size_t operator()(const component_event &ev) const noexcept {
-            std::size_t h1 = std::hash<comp_event>{}(ev.first);
-            std::size_t h2 = std::hash<std::type_index>{}(ev.second);
-            // Combine the hashes using a common bit-mixing method.
-            return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2)); // NOLINT
-        }
-    };
-    struct equal {
-        bool operator()(const component_event &lhs, const component_event &rhs) const {
-            return lhs.first == rhs.first && ((lhs.second <=> rhs.second) == 0);
-        }
+        signal<batch_signal_signature> batch_sig;
+        sink<decltype(batch_sig)> batch_sk{batch_sig};
+        // Pending entities of active `batch` scopes, in order of their first event
+        std::uint32_t batch_depth{};
+        change_tracker batched;
     };
 
     void entity_destroyed_handler(entt::registry &, entt::entity en) {
+        for(auto &changes: m_trackers) {
+            if(changes) {
+                changes->unmark(en);
+            }
+        }
         m_entity_destroyed.publish(en);
     }
 
-    template<comp_event ev, component comp>
-    static inline const component_event event_key{.first = ev, .second = typeid(std::decay_t<comp>)};
+    static constexpr std::size_t comp_event_count = 3;
+    static_assert(static_cast<std::size_t>(comp_event::update) < comp_event_count);
     entt::registry m_registry;
-    std::unordered_map<component_event, signal_pair, hasher, equal> m_component_signals;
+    // Indexed by `event_slot`, signals are boxed because sinks point to them
+    std::vector<std::unique_ptr<signal_pair>> m_component_signals;
+    // Indexed by `entt::type_index` of the tag
+    std::vector<std::unique_ptr<change_tracker>> m_trackers;
+    // Indexed by `entt::type_index` of the component, 0 until requested
+    std::vector<std::uint64_t> m_storage_versions;
+    // Indexed by `entt::type_index` of the component and the kind of filter, boxed because signals point to them
+    std::vector<std::unique_ptr<change_log>> m_change_logs;
     signal<void(entity)> m_entity_destroyed;
     sink<decltype(m_entity_destroyed)> m_entity_destroyed_sink{m_entity_destroyed};
 };
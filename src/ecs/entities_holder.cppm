@@ -1,9 +1,10 @@
 module;
 
-#include <algorithm>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
+#include <span>
+#include <unordered_map>
 #include <vector>
 #include <entt/entt.hpp>
 
@@ -18,6 +19,7 @@ export namespace st {
 /**
  * @brief Owns a set of entities
  * @note Caller must call `discard` in handler of the `ecs_registry`'s `on_entity_destroyed` if destroyed entity is owned by this node
+ * @note Removal moves the last entity into the freed slot, so only index 0 keeps its position
  */
 
 class entities_holder {
@@ -66,11 +68,38 @@ public:
      */
     entity create() {
         const auto result = m_registry.get().create();
-        m_entities.emplace_back(result);
+        push(result);
         m_entity_created.publish(result);
         return result;
     }
 
+    /**
+     * @brief Creates `count` new entities and publishes them once through `on_create_batch`
+     * @return Created entities, valid until the next modification of this holder
+     */
+    std::span<const entity> create_n(std::size_t count) {
+        const auto first = m_entities.size();
+        m_entities.resize(first + count);
+        const std::span<entity> created{m_entities.begin() + static_cast<std::ptrdiff_t>(first), count};
+        m_registry.get().create(created);
+        m_slots.reserve(m_entities.size());
+        for(auto i = first; i < m_entities.size(); ++i) {
+            m_slots.emplace(m_entities[i], i);
+        }
+        m_entities_created.publish(created);
+        return created;
+    }
+
+    /**
+     * @brief Takes ownership of an existing entity, used when loading snapshots
+     */
+    void adopt(entity en) {
+        assert(m_registry.get().contains(en) && "Invalid entity");
+        assert(!m_slots.contains(en) && "Entity is already owned");
+        push(en);
+        m_entity_created.publish(en);
+    }
+
     /**
      * @brief Erases entity by index
      * @brief Entity at index 0 must be destroyed last
@@ -82,21 +111,30 @@ public:
             && "Entity at index 0 must be destroyed last");
         const auto destroyed_entity = m_entities[index];
         m_registry.get().destroy(destroyed_entity);
-        assert(!std::ranges::contains(m_entities, destroyed_entity) && "Caller did not call discard");
+        assert(!m_slots.contains(destroyed_entity) && "Caller did not call discard");
     }
 
     /**
      * @brief Remove ownership of an entity without destroying it
+     * @note The last entity takes the slot of the removed one, entity at index 0 stays in place
      */
     void discard(entity en) {
-        auto it = std::ranges::find(m_entities, en);
-        assert(it != m_entities.end() && "Entity not found");
+        if(m_is_tearing_down) {
+            assert(m_slots.contains(en) && "Entity not found");
+            return;
+        }
+        const auto it = m_slots.find(en);
+        assert(it != m_slots.end() && "Entity not found");
+        const auto index = it->second;
         assert(
-            ((it == m_entities.begin() && m_entities.size() == 1)
-             || it != m_entities.begin())
+            (index > 0 || m_entities.size() == 1)
             && "Cannot discard entity at index 0 before others");
         m_on_entity_destroy.publish(en);
-        m_entities.erase(it);
+        const auto last = m_entities.back();
+        m_entities[index] = last;
+        m_slots[last] = index;
+        m_entities.pop_back();
+        m_slots.erase(en);
     }
 
     /**
@@ -104,11 +142,49 @@ public:
      * @note Entity at index 0 must be destroyed last
      */
     void destroy(entity en) {
-        auto it = std::ranges::find(m_entities, en);
-        assert(it != m_entities.end() && "Entity not found");
+        const auto it = m_slots.find(en);
+        assert(it != m_slots.end() && "Entity not found");
+        destroy(static_cast<std::ptrdiff_t>(it->second));
+    }
 
-        std::ptrdiff_t index = std::distance(m_entities.begin(), it);
-        destroy(index);
+    /**
+     * @brief Destroys every entity at once, publishing them through `on_destroy_batch` instead of `on_destroy`
+     *
+     * Entities stay owned, including the one at index 0, until all of them are destroyed
+     */
+    void destroy_all() {
+        if(m_entities.empty()) {
+            return;
+        }
+        m_entities_destroyed.publish(std::span<const entity>{m_entities});
+        begin_teardown();
+        m_registry.get().destroy(std::span<const entity>{m_entities});
+        end_teardown();
+    }
+
+    /**
+     * @brief Keeps every entity owned while they are destroyed in bulk, `discard` does nothing until `end_teardown`
+     * @note No signal is published, the caller notifies listeners of the whole batch
+     */
+    void begin_teardown() {
+        m_is_tearing_down = true;
+    }
+
+    /**
+     * @brief Drops ownership of every entity after a bulk destruction started with `begin_teardown`
+     */
+    void end_teardown() {
+        assert(m_is_tearing_down && "Teardown was not started");
+        m_is_tearing_down = false;
+        m_entities.clear();
+        m_slots.clear();
+    }
+
+    /**
+     * @return Whether this holder owns `en`
+     */
+    [[nodiscard]] bool contains(entity en) const {
+        return m_slots.contains(en);
     }
 
     [[nodiscard]] std::size_t size() const {
@@ -163,14 +239,40 @@ public:
         return this->m_on_entity_destroy_sink;
     }
 
+    /**
+     * @brief Signal after `create_n`
+     */
+    decltype(auto) on_create_batch() {
+        return this->m_entities_created_sink;
+    }
+
+    /**
+     * @brief Signal before `destroy_all` destroys the entities
+     */
+    decltype(auto) on_destroy_batch() {
+        return this->m_entities_destroyed_sink;
+    }
+
 private:
+    void push(entity en) {
+        m_slots.emplace(en, m_entities.size());
+        m_entities.emplace_back(en);
+    }
+
     std::reference_wrapper<ecs_registry> m_registry;
     std::vector<entity> m_entities;
+    // Index of each entity in `m_entities`
+    std::unordered_map<entity, std::size_t, entity_hasher, entity_equal> m_slots;
+    bool m_is_tearing_down{};
 
     signal<void(entity)> m_entity_created;
     sink<decltype(m_entity_created)> m_entity_created_sink{m_entity_created};
     signal<void(entity)> m_on_entity_destroy;
     sink<decltype(m_on_entity_destroy)> m_on_entity_destroy_sink{m_on_entity_destroy};
+    signal<void(std::span<const entity>)> m_entities_created;
+    sink<decltype(m_entities_created)> m_entities_created_sink{m_entities_created};
+    signal<void(std::span<const entity>)> m_entities_destroyed;
+    sink<decltype(m_entities_destroyed)> m_entities_destroyed_sink{m_entities_destroyed};
 };
 
 } // namespace st
\ No newline at end of file
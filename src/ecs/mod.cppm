@@ -1,11 +1,16 @@
 export module stay3.ecs;
 
+export import :change_tracker;
+export import :command_buffer;
 export import :component_ref;
 export import :component;
 export import :dependency;
 export import :ecs_registry;
 export import :entities_holder;
 export import :entity;
+export import :prefab;
+export import :snapshot;
 export import :system_data;
 export import :system_manager;
+export import :system_profiler;
 export import :system_wrapper;
\ No newline at end of file
@@ -0,0 +1,60 @@
+module;
+
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+export module stay3.ecs:prefab;
+
+import :entity;
+import :component;
+import :ecs_registry;
+
+export namespace st {
+/**
+ * @brief Set of component values to copy onto many entities at once
+ * @example
+ * ```
+ * prefab platform{transform{}, rigidbody{}, collider{box{}}};
+ * platform.get<transform>().set_scale(...);
+ * platform.instantiate(registry, entities);
+ * ```
+ */
+template<component... comps>
+    requires(sizeof...(comps) > 0 && (!is_mut_v<comps> && ...))
+class prefab {
+public:
+    prefab()
+        requires(std::is_default_constructible_v<comps> && ...)
+    = default;
+    explicit prefab(comps... values)
+        : m_values{std::move(values)...} {}
+
+    template<component comp>
+    [[nodiscard]] comp &get() {
+        return std::get<comp>(m_values);
+    }
+    template<component comp>
+    [[nodiscard]] const comp &get() const {
+        return std::get<comp>(m_values);
+    }
+
+    /**
+     * @brief Copies the components onto `entities`, which must not have any of them
+     *
+     * Storage of each component type is reserved once. Construct events are published after every
+     * component is emplaced, one batch per component type in declaration order
+     */
+    void instantiate(ecs_registry &reg, std::span<const entity> entities) const {
+        auto scope = reg.batch<comp_event::construct, comps...>();
+        (reg.insert<comps>(entities, std::get<comps>(m_values)), ...);
+    }
+
+private:
+    std::tuple<comps...> m_values;
+};
+
+template<component... comps>
+prefab(comps...) -> prefab<comps...>;
+} // namespace st
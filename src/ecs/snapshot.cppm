@@ -0,0 +1,315 @@
+module;
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <entt/entt.hpp>
+
+export module stay3.ecs:snapshot;
+
+import stay3.core;
+import :entity;
+import :component;
+import :ecs_registry;
+
+export namespace st {
+
+struct snapshot_error: public error {
+    using error::error;
+};
+
+/**
+ * @brief Appends snapshot data to an in-memory buffer, which is written to disk in one go
+ */
+class snapshot_writer {
+public:
+    void write(std::span<const std::byte> bytes) {
+        m_buffer.insert(m_buffer.end(), bytes.begin(), bytes.end());
+    }
+
+    template<typename type>
+        requires std::is_trivially_copyable_v<type>
+    void write(const type &value) {
+        write(std::as_bytes(std::span{&value, 1}));
+    }
+
+    template<typename type>
+        requires std::is_trivially_copyable_v<type>
+    void write(const std::vector<type> &values) {
+        write(static_cast<std::uint64_t>(values.size()));
+        write(std::as_bytes(std::span{values}));
+    }
+
+    [[nodiscard]] std::span<const std::byte> data() const {
+        return m_buffer;
+    }
+
+    /**
+     * @throw `file_error` if the file cannot be written
+     */
+    void save(const std::filesystem::path &path) const {
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!file) {
+            throw file_error{"Failed to open: " + path.string()};
+        }
+        file.write(reinterpret_cast<const char *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+        if(!file) {
+            throw file_error{"Failed to write: " + path.string()};
+        }
+    }
+
+private:
+    std::vector<std::byte> m_buffer;
+};
+
+class ecs_snapshot_loader;
+
+/**
+ * @brief Sequential reader over a snapshot, usually backed by a `mapped_file`
+ */
+class snapshot_reader {
+public:
+    snapshot_reader(std::span<const std::byte> data)
+        : m_data{data} {}
+
+    /**
+     * @throw `snapshot_error` if the snapshot is truncated
+     */
+    void read(std::span<std::byte> bytes) {
+        if(bytes.size() > m_data.size() - m_offset) {
+            throw snapshot_error{"Truncated snapshot"};
+        }
+        std::memcpy(bytes.data(), m_data.data() + m_offset, bytes.size());
+        m_offset += bytes.size();
+    }
+
+    template<typename type>
+        requires std::is_trivially_copyable_v<type> && std::default_initializable<type>
+    [[nodiscard]] type read() {
+        type result;
+        read(std::as_writable_bytes(std::span{&result, 1}));
+        return result;
+    }
+
+    template<typename type>
+        requires std::is_trivially_copyable_v<type>
+    void read(std::vector<type> &values) {
+        const auto size = read<std::uint64_t>();
+        if(size > (m_data.size() - m_offset) / sizeof(type)) {
+            throw snapshot_error{"Truncated snapshot"};
+        }
+        values.resize(static_cast<std::size_t>(size));
+        read(std::as_writable_bytes(std::span{values}));
+    }
+
+    /**
+     * @brief Reads an entity written while saving and maps it to the loaded one
+     */
+    [[nodiscard]] entity read_entity();
+
+    [[nodiscard]] bool is_end() const {
+        return m_offset == m_data.size();
+    }
+
+private:
+    friend class ecs_snapshot_loader;
+    std::span<const std::byte> m_data;
+    std::size_t m_offset{};
+    const ecs_snapshot_loader *m_loader{};
+};
+
+/**
+ * @brief Serialization trait, specialize it with `save` and `load` to make a component saveable
+ * @example
+ * ```
+ * template<>
+ * struct snapshot_traits<comp> {
+ *     static void save(snapshot_writer &out, const comp &value);
+ *     static void load(snapshot_reader &in, comp &value);
+ * };
+ * ```
+ */
+template<typename comp>
+struct snapshot_traits;
+
+/**
+ * @brief Stable id of a saved component type, written before its components and checked while loading
+ *
+ * Specialize it for every saved type, including empty ones. Ids with the high bit set are reserved for stay3 types
+ * @example
+ * ```
+ * template<>
+ * struct snapshot_id<comp>: std::integral_constant<std::uint32_t, 1> {};
+ * ```
+ */
+template<typename comp>
+struct snapshot_id;
+
+/**
+ * @brief Traits copying the component bytes as is
+ */
+template<typename comp>
+    requires std::is_trivially_copyable_v<comp>
+struct trivial_snapshot_traits {
+    static void save(snapshot_writer &out, const comp &value) {
+        out.write(value);
+    }
+    static void load(snapshot_reader &in, comp &value) {
+        in.read(std::as_writable_bytes(std::span{&value, 1}));
+    }
+};
+
+/**
+ * @brief Empty components do not need traits
+ */
+template<typename comp>
+concept snapshot_component =
+    component<comp>
+    && std::default_initializable<comp>
+    && requires { { snapshot_id<comp>::value } -> std::convertible_to<std::uint32_t>; }
+    && (std::is_empty_v<comp>
+        || requires(snapshot_writer &out, snapshot_reader &in, const comp &saved, comp &loaded) {
+               snapshot_traits<comp>::save(out, saved);
+               snapshot_traits<comp>::load(in, loaded);
+           });
+
+template<>
+struct snapshot_id<transform>: std::integral_constant<std::uint32_t, 0x8000'0001> {};
+
+template<>
+struct snapshot_traits<transform> {
+    static void save(snapshot_writer &out, const transform &value) {
+        out.write(value.position());
+        out.write(value.orientation());
+        out.write(value.scale());
+    }
+    static void load(snapshot_reader &in, transform &value) {
+        value.set_position(in.read<vec3f>());
+        value.set_orientation(in.read<quaternionf>());
+        value.set_scale(in.read<vec3f>());
+    }
+};
+
+/**
+ * @brief Saves registry content with EnTT snapshots
+ *
+ * Entities must be saved before components
+ */
+class ecs_snapshot {
+public:
+    static void save_entities(const ecs_registry &reg, snapshot_writer &out) {
+        output_archive archive{out};
+        entt::snapshot{reg.m_registry}.get<entt::entity>(archive);
+    }
+
+    /**
+     * @brief Saves components of every type in `comps`, prefixed by a type id which is checked while loading
+     */
+    template<snapshot_component... comps>
+    static void save_components(const ecs_registry &reg, snapshot_writer &out) {
+        output_archive archive{out};
+        entt::snapshot snapshot{reg.m_registry};
+        ((out.write(static_cast<std::uint32_t>(snapshot_id<comps>::value)), snapshot.template get<comps>(archive)), ...);
+    }
+
+private:
+    struct output_archive {
+        snapshot_writer &out;
+        void operator()(std::underlying_type_t<entt::entity> value) {
+            out.write(value);
+        }
+        void operator()(entt::entity value) {
+            out.write(value);
+        }
+        template<typename comp>
+        void operator()(const comp &value) {
+            snapshot_traits<comp>::save(out, value);
+        }
+    };
+};
+
+/**
+ * @brief Loads what `ecs_snapshot` saved into a registry, loaded entities are new local entities
+ *
+ * Components are emplaced, so construct signals rebuild the derived state
+ */
+class ecs_snapshot_loader {
+public:
+    ecs_snapshot_loader(ecs_registry &reg, snapshot_reader &in)
+        : m_loader{reg.m_registry}, m_reader{in} {
+        assert(m_reader.m_loader == nullptr && "Reader is used by another loader");
+        m_reader.m_loader = this;
+    }
+    ~ecs_snapshot_loader() {
+        m_reader.m_loader = nullptr;
+    }
+    ecs_snapshot_loader(const ecs_snapshot_loader &) = delete;
+    ecs_snapshot_loader(ecs_snapshot_loader &&) noexcept = delete;
+    ecs_snapshot_loader &operator=(const ecs_snapshot_loader &) = delete;
+    ecs_snapshot_loader &operator=(ecs_snapshot_loader &&) noexcept = delete;
+
+    void load_entities() {
+        input_archive archive{m_reader};
+        m_loader.get<entt::entity>(archive);
+    }
+
+    /**
+     * @throw `snapshot_error` if saved types do not match `comps`
+     */
+    template<snapshot_component... comps>
+    void load_components() {
+        input_archive archive{m_reader};
+        const auto load_one = [&]<typename comp>() {
+            if(m_reader.read<std::uint32_t>() != static_cast<std::uint32_t>(snapshot_id<comp>::value)) {
+                throw snapshot_error{"Component types do not match the snapshot"};
+            }
+            m_loader.get<comp>(archive);
+        };
+        (load_one.template operator()<comps>(), ...);
+    }
+
+    /**
+     * @return Loaded entity of a saved one
+     * @throw `snapshot_error` if `saved` is not among the saved entities
+     */
+    [[nodiscard]] entity map(entity saved) const {
+        if(saved.is_null()) {
+            return saved;
+        }
+        if(!m_loader.contains(saved)) {
+            throw snapshot_error{"Unknown entity in snapshot"};
+        }
+        return m_loader.map(saved);
+    }
+
+private:
+    struct input_archive {
+        snapshot_reader &in;
+        void operator()(std::underlying_type_t<entt::entity> &value) {
+            value = in.read<std::underlying_type_t<entt::entity>>();
+        }
+        void operator()(entt::entity &value) {
+            value = in.read<entt::entity>();
+        }
+        template<typename comp>
+        void operator()(comp &value) {
+            snapshot_traits<comp>::load(in, value);
+        }
+    };
+
+    entt::continuous_loader m_loader;
+    snapshot_reader &m_reader;
+};
+
+entity snapshot_reader::read_entity() {
+    assert(m_loader != nullptr && "Entities can only be read while loading");
+    return m_loader->map(read<entity>());
+}
+} // namespace st
@@ -1,6 +1,7 @@
 module;
 
 #include <cstdint>
+#include <string_view>
 #include <type_traits>
 
 export module stay3.ecs:system_data;
@@ -23,6 +24,24 @@ enum class sys_type : std::uint8_t {
 };
 using sys_type_t = std::underlying_type_t<sys_type>;
 
+constexpr std::string_view sys_type_name(sys_type type) {
+    switch(type) {
+    case sys_type::update:
+        return "update";
+    case sys_type::start:
+        return "start";
+    case sys_type::cleanup:
+        return "cleanup";
+    case sys_type::render:
+        return "render";
+    case sys_type::post_update:
+        return "post_update";
+    case sys_type::input:
+        return "input";
+    }
+    return "unknown";
+}
+
 template<typename sys, typename context>
 concept is_update_system = requires(sys &system, seconds delta, context &ctx) {
     system.update(delta, ctx);
@@ -84,6 +103,43 @@ enum class sys_priority : std::uint8_t {
 };
 using sys_priority_t = std::underlying_type_t<sys_priority>;
 
+/**
+ * @brief Components a system reads, `mut<comp>` for the ones it writes
+ *
+ * Systems declaring their access may share a wave with the ones they do not conflict with.
+ * A wave runs on the thread pool only when all of its systems are `is_concurrent_system`, otherwise in priority order
+ * @example
+ * ```
+ * struct movement_system {
+ *     using access = sys_access<velocity, mut<position>>;
+ *     void update(seconds delta, tree_context &ctx);
+ * };
+ * ```
+ */
+template<typename... comps>
+struct sys_access {};
+
+template<typename sys>
+concept has_sys_access = requires { typename sys::access; };
+
+/**
+ * @brief System opting in to run on worker threads alongside the other systems of its wave
+ *
+ * It only looks up the components of its `access`, through `get`, `each` and `contains`, and neither creates nor
+ * destroys entities or components. It does not use trackers, `watch`, `on`, context variables or frame memory.
+ * Before the wave, storages of the wave are created, and it falls back to serial if a written component is observed
+ * @example
+ * ```
+ * struct movement_system {
+ *     using access = sys_access<velocity, mut<position>>;
+ *     static constexpr bool is_concurrent = true;
+ *     void update(seconds delta, tree_context &ctx);
+ * };
+ * ```
+ */
+template<typename sys>
+concept is_concurrent_system = has_sys_access<sys> && requires { requires sys::is_concurrent; };
+
 enum class sys_run_result : std::uint8_t {
     noop,
     exit,
@@ -1,13 +1,23 @@
 module;
 
+#include <algorithm>
+#include <atomic>
+#include <concepts>
 #include <cassert>
+#include <cstddef>
+#include <format>
 #include <functional>
 #include <memory>
 #include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
+#include <entt/entt.hpp>
 
 export module stay3.ecs:system_manager;
 
@@ -15,17 +25,87 @@ import stay3.core;
 import stay3.input;
 import :system_data;
 import :system_wrapper;
+import :system_profiler;
+import :ecs_registry;
+
+namespace st {
+template<typename context>
+concept has_ecs_registry = requires(context &ctx) { { ctx.ecs() } -> std::same_as<ecs_registry &>; };
+} // namespace st
 
 export namespace st {
 
 /**
  * @brief Manage systems registration and call their methods
+ *
+ * Systems of the same type run in priority order, except that a wave of non-conflicting
+ * `is_concurrent_system` systems runs concurrently on the thread pool
  */
 template<typename context>
 class system_manager {
+    using wrapper = system_wrapper<context>;
+
+    struct access_info {
+        // Undeclared access conflicts with every system
+        bool is_declared{};
+        bool is_concurrent{};
+        std::vector<entt::id_type> reads;
+        std::vector<entt::id_type> writes;
+        // Creates the storage of each component, false if it cannot be accessed from worker threads
+        std::vector<bool (*)(ecs_registry &)> prepares;
+
+        [[nodiscard]] bool conflicts_with(const access_info &other) const {
+            if(!is_declared || !other.is_declared) {
+                return true;
+            }
+            constexpr auto overlaps = [](const auto &lhs, const auto &rhs) {
+                return std::ranges::any_of(lhs, [&rhs](auto id) { return std::ranges::contains(rhs, id); });
+            };
+            return overlaps(writes, other.writes)
+                   || overlaps(writes, other.reads)
+                   || overlaps(reads, other.writes);
+        }
+
+        template<typename... comps>
+        static access_info from(sys_access<comps...>) {
+            access_info result{.is_declared = true};
+            (result.add<comps>(), ...);
+            return result;
+        }
+
+    private:
+        template<typename comp>
+        void add() {
+            const auto id = entt::type_hash<std::decay_t<remove_mut_t<comp>>>::value();
+            if constexpr(is_mut_v<comp>) {
+                writes.push_back(id);
+            } else {
+                reads.push_back(id);
+            }
+            prepares.push_back([](ecs_registry &reg) { return reg.prepare_concurrent_access<comp>(); });
+        }
+    };
+
+    struct system_entry {
+        template<typename sys, typename... sys_ctor_args>
+        system_entry(std::in_place_type_t<sys>, sys_ctor_args &&...args)
+            : system{std::in_place_type<sys>, std::forward<sys_ctor_args>(args)...},
+              name{entt::type_name<sys>::value()} {
+            if constexpr(has_sys_access<sys>) {
+                access = access_info::from(typename sys::access{});
+            }
+            access.is_concurrent = is_concurrent_system<sys>;
+        }
+
+        wrapper system;
+        std::string_view name;
+        access_info access;
+    };
+
     struct system_entry_per_type {
-        std::reference_wrapper<system_wrapper<context>> system;
+        std::reference_wrapper<system_entry> system;
         sys_priority_t priority;
+        system_profiler::zone_id zone{};
         bool operator<(const system_entry_per_type &other) const {
             if(priority == other.priority) {
                 return std::addressof(system.get()) < std::addressof(other.system.get());
@@ -37,7 +117,18 @@ class system_manager {
         }
     };
 
-    using wrapper = system_wrapper<context>;
+    struct scheduled_system {
+        system_entry *system;
+        system_profiler::zone_id zone;
+    };
+
+    struct schedule {
+        std::set<system_entry_per_type> entries;
+        // Systems in the same wave do not conflict, waves run in order
+        std::vector<std::vector<scheduled_system>> waves;
+        bool is_dirty{true};
+    };
+
     /**
      * @brief Register system roles to manager
      */
@@ -46,7 +137,7 @@ class system_manager {
         using priority = std::variant<sys_priority, sys_priority_t>;
         using types = std::underlying_type_t<sys_type>;
 
-        base_proxy(wrapper &system, system_manager &manager)
+        base_proxy(system_entry &system, system_manager &manager)
             : m_system{system}, m_manager{manager} {}
 
     protected:
@@ -59,12 +150,28 @@ class system_manager {
             assert((static_cast<types>(type) & m_registered_types) == 0 && "System type registered twice");
             m_registered_types |= static_cast<types>(type);
 
-            m_manager.get().m_systems_by_type[type].insert({.system = m_system, .priority = order_as_num});
+            auto &manager = m_manager.get();
+            system_profiler::zone_id zone{};
+            if constexpr(profiler_enabled) {
+                zone = manager.m_profiler.add_zone(m_system.get().name, type);
+            }
+            auto &sched = manager.m_schedules[type];
+            sched.entries.insert({.system = m_system, .priority = order_as_num, .zone = zone});
+            sched.is_dirty = true;
+        }
+
+        template<typename... comps>
+        void access() {
+            auto &access = m_system.get().access;
+            const auto is_concurrent = access.is_concurrent;
+            access = access_info::from(sys_access<comps...>{});
+            access.is_concurrent = is_concurrent;
+            m_manager.get().invalidate_schedules();
         }
 
     private:
         types m_registered_types{};
-        std::reference_wrapper<wrapper> m_system;
+        std::reference_wrapper<system_entry> m_system;
         std::reference_wrapper<system_manager<context>> m_manager;
     };
     /**
@@ -81,12 +188,25 @@ class system_manager {
             base_proxy::template run_as<type>(order);
             return *this;
         }
+
+        /**
+         * @brief Declares components the system reads, `mut<comp>` for the ones it writes
+         * @note Overrides the system's `access` member type
+         */
+        template<typename... comps>
+        proxy &access() {
+            base_proxy::template access<comps...>();
+            return *this;
+        }
     };
 
 public:
+    explicit system_manager(thread_pool &pool = default_thread_pool())
+        : m_pool{pool} {}
+
     template<typename sys, typename... sys_ctor_args>
     proxy<sys> add(sys_ctor_args &&...args) {
-        auto &sys_ptr = m_systems.emplace_back(std::make_unique<wrapper>(std::in_place_type<sys>, std::forward<sys_ctor_args>(args)...));
+        auto &sys_ptr = m_systems.emplace_back(std::make_unique<system_entry>(std::in_place_type<sys>, std::forward<sys_ctor_args>(args)...));
         return {*sys_ptr, *this};
     }
 
@@ -114,26 +234,133 @@ public:
         return apply_all<sys_type::post_update>(delta, ctx);
     }
 
+    /**
+     * @brief Per-system timings, only recorded when `profiler_enabled`
+     */
+    [[nodiscard]] system_profiler &profiler() {
+        return m_profiler;
+    }
+
+    /**
+     * @brief Human readable schedule of `type`, one line per wave of non-conflicting systems
+     */
+    [[nodiscard]] std::string dump_schedule(sys_type type) {
+        auto &sched = schedule_of(type);
+        std::string result;
+        for(std::size_t i = 0; i < sched.waves.size(); ++i) {
+            result += std::format("wave {}:", i);
+            for(const auto &scheduled: sched.waves[i]) {
+                result += std::format(" {}", scheduled.system->name);
+            }
+            result += '\n';
+        }
+        return result;
+    }
+
 private:
     template<sys_type type, typename... args>
     sys_run_result apply_all(args &&...arguments) {
-        auto res = sys_run_result::noop;
-        for(const auto &entry: m_systems_by_type[type]) {
-            auto cur = entry.system.get().template call_method<type>(std::forward<args>(arguments)...);
-            switch(cur) {
-            case sys_run_result::noop:
-                break;
-            case sys_run_result::exit:
+        // The context is the last argument of every system method
+        auto &ctx = std::get<sizeof...(args) - 1>(std::forward_as_tuple(arguments...));
+        for(const auto &wave: schedule_of(type).waves) {
+            if(wave.size() == 1 || !prepare_concurrent_wave(wave, ctx)) {
+                for(const auto &scheduled: wave) {
+                    if(call<type>(scheduled, arguments...) == sys_run_result::exit) {
+                        return sys_run_result::exit;
+                    }
+                }
+                continue;
+            }
+            std::atomic<bool> should_exit{};
+            m_pool.get().parallel_for(wave.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for(auto i = begin; i < end; ++i) {
+                    if(call<type>(wave[i], arguments...) == sys_run_result::exit) {
+                        should_exit.store(true, std::memory_order_relaxed);
+                    }
+                }
+            });
+            // Systems of the same wave are unordered, so the whole wave finishes before exiting
+            if(should_exit.load(std::memory_order_relaxed)) {
                 return sys_run_result::exit;
-            default:
-                // Potentially more control result types
-                break;
             }
         }
-        return res;
+        return sys_run_result::noop;
+    }
+
+    template<sys_type type, typename... args>
+    sys_run_result call(const scheduled_system &scheduled, args &...arguments) {
+        if constexpr(profiler_enabled) {
+            const auto start = tick_watch::now();
+            const auto result = scheduled.system->system.template call_method<type>(arguments...);
+            m_profiler.record(scheduled.zone, start, tick_watch::now() - start);
+            return result;
+        } else {
+            return scheduled.system->system.template call_method<type>(arguments...);
+        }
+    }
+
+    /**
+     * @brief Whether `wave` may run on the thread pool, creating the storages its systems look up
+     */
+    static bool prepare_concurrent_wave(const std::vector<scheduled_system> &wave, context &ctx) {
+        if(!std::ranges::all_of(wave, [](const auto &scheduled) { return scheduled.system->access.is_concurrent; })) {
+            return false;
+        }
+        if constexpr(has_ecs_registry<context>) {
+            auto &reg = ctx.ecs();
+            bool is_safe = true;
+            for(const auto &scheduled: wave) {
+                for(auto prepare: scheduled.system->access.prepares) {
+                    is_safe = prepare(reg) && is_safe;
+                }
+            }
+            return is_safe;
+        } else {
+            return true;
+        }
+    }
+
+    schedule &schedule_of(sys_type type) {
+        auto &sched = m_schedules[type];
+        if(sched.is_dirty) {
+            build_waves(sched);
+        }
+        return sched;
+    }
+
+    /**
+     * @brief Places each system one wave after the last conflicting system with higher priority
+     */
+    static void build_waves(schedule &sched) {
+        sched.waves.clear();
+        std::vector<std::pair<system_entry *, std::size_t>> placed;
+        placed.reserve(sched.entries.size());
+        for(const auto &entry: sched.entries) {
+            auto &current = entry.system.get();
+            std::size_t wave = 0;
+            for(const auto &[other, other_wave]: placed) {
+                if(current.access.conflicts_with(other->access)) {
+                    wave = std::max(wave, other_wave + 1);
+                }
+            }
+            if(wave == sched.waves.size()) {
+                sched.waves.emplace_back();
+            }
+            sched.waves[wave].push_back({.system = &current, .zone = entry.zone});
+            placed.emplace_back(&current, wave);
+        }
+        sched.is_dirty = false;
+    }
+
+    void invalidate_schedules() {
+        for(auto &[type, sched]: m_schedules) {
+            sched.is_dirty = true;
+        }
     }
 
-    std::unordered_map<sys_type, std::set<system_entry_per_type>> m_systems_by_type;
-    std::vector<std::unique_ptr<wrapper>> m_systems;
+    std::reference_wrapper<thread_pool> m_pool;
+    std::unordered_map<sys_type, schedule> m_schedules;
+    std::vector<std::unique_ptr<system_entry>> m_systems;
+    system_profiler m_profiler;
 };
-} // namespace st
\ No newline at end of file
+} // namespace st
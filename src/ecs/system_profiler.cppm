@@ -0,0 +1,202 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+export module stay3.ecs:system_profiler;
+
+import stay3.core;
+import :system_data;
+
+export namespace st {
+
+/**
+ * @brief Whether `system_manager` times its systems, enabled by the `stay3_ENABLE_PROFILER` CMake option
+ */
+#ifdef STAY3_PROFILER
+constexpr bool profiler_enabled = true;
+#else
+constexpr bool profiler_enabled = false;
+#endif
+
+/**
+ * @brief Timing of one system in one phase over the last `system_profiler::window_size` calls
+ */
+struct zone_stats {
+    std::string_view system;
+    sys_type phase;
+    std::size_t samples;
+    ticks min;
+    ticks avg;
+    ticks p99;
+};
+
+/**
+ * @brief Rolling per-system statistics and Chrome trace capture
+ *
+ * A zone is only recorded by one thread at a time, trace events are shared between threads
+ */
+class system_profiler {
+public:
+    using zone_id = std::size_t;
+    static constexpr std::size_t window_size = 128;
+
+    zone_id add_zone(std::string_view system, sys_type phase) {
+        m_zones.emplace_back(std::make_unique<zone>(zone{.system = system, .phase = phase}));
+        return m_zones.size() - 1;
+    }
+
+    void record(zone_id id, ticks start, ticks duration) {
+        auto &current = *m_zones[id];
+        current.durations[current.next] = duration;
+        current.next = (current.next + 1) % window_size;
+        current.samples = std::min(current.samples + 1, window_size);
+        if(m_frame >= m_trace_first_frame && m_frame <= m_trace_last_frame) {
+            const std::scoped_lock lock{m_trace_mutex};
+            m_trace.push_back({
+                .zone = id,
+                .frame = m_frame,
+                .thread = std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                .start = start,
+                .duration = duration,
+            });
+        }
+    }
+
+    /**
+     * @brief Marks the start of a new frame
+     */
+    void next_frame() {
+        ++m_frame;
+    }
+
+    [[nodiscard]] std::uint64_t frame() const {
+        return m_frame;
+    }
+
+    /**
+     * @brief Statistics of zones that were recorded at least once
+     */
+    [[nodiscard]] std::vector<zone_stats> stats() const {
+        std::vector<zone_stats> result;
+        std::vector<ticks> sorted;
+        for(const auto &current: m_zones) {
+            if(current->samples == 0) {
+                continue;
+            }
+            sorted.assign(current->durations.begin(), current->durations.begin() + static_cast<std::ptrdiff_t>(current->samples));
+            std::ranges::sort(sorted);
+            ticks sum{};
+            for(const auto duration: sorted) {
+                sum += duration;
+            }
+            constexpr std::size_t percentile = 99;
+            result.push_back({
+                .system = current->system,
+                .phase = current->phase,
+                .samples = current->samples,
+                .min = sorted.front(),
+                .avg = sum / static_cast<ticks>(sorted.size()),
+                .p99 = sorted[(sorted.size() - 1) * percentile / 100],
+            });
+        }
+        return result;
+    }
+
+    /**
+     * @brief Captures trace events of frames in [first_frame, last_frame], discarding the previous capture
+     * @note Call it between frames
+     */
+    void capture_trace(std::uint64_t first_frame, std::uint64_t last_frame) {
+        const std::scoped_lock lock{m_trace_mutex};
+        m_trace.clear();
+        m_trace_first_frame = first_frame;
+        m_trace_last_frame = last_frame;
+    }
+
+    /**
+     * @brief Writes captured events in Chrome trace event JSON, viewable in `chrome://tracing` or Perfetto
+     */
+    void write_chrome_trace(std::ostream &out) const {
+        const std::scoped_lock lock{m_trace_mutex};
+        out << R"({"traceEvents":[)";
+        constexpr double ns_per_us = 1000.;
+        for(std::size_t i = 0; i < m_trace.size(); ++i) {
+            const auto &event = m_trace[i];
+            const auto &current = *m_zones[event.zone];
+            out << std::format(
+                R"({}{{"name":"{}","cat":"{}","ph":"X","pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f},"args":{{"frame":{}}}}})",
+                i == 0 ? "" : ",",
+                escaped(current.system),
+                sys_type_name(current.phase),
+                event.thread,
+                static_cast<double>(event.start) / ns_per_us,
+                static_cast<double>(event.duration) / ns_per_us,
+                event.frame);
+        }
+        out << "]}";
+    }
+
+    /**
+     * @throw `file_error` if the file cannot be written
+     */
+    void write_chrome_trace(const std::filesystem::path &path) const {
+        std::ofstream file{path};
+        if(!file) {
+            throw file_error{"Failed to open: " + path.string()};
+        }
+        write_chrome_trace(file);
+    }
+
+private:
+    struct zone {
+        std::string_view system;
+        sys_type phase;
+        std::array<ticks, window_size> durations{};
+        std::size_t next{};
+        std::size_t samples{};
+    };
+
+    struct trace_event {
+        zone_id zone;
+        std::uint64_t frame;
+        std::size_t thread;
+        ticks start;
+        ticks duration;
+    };
+
+    static std::string escaped(std::string_view text) {
+        std::string result;
+        result.reserve(text.size());
+        for(const auto character: text) {
+            if(character == '"' || character == '\\') {
+                result += '\\';
+            }
+            result += character;
+        }
+        return result;
+    }
+
+    // Boxed so recording threads never see a reallocation
+    std::vector<std::unique_ptr<zone>> m_zones;
+    std::uint64_t m_frame{};
+
+    mutable std::mutex m_trace_mutex;
+    std::vector<trace_event> m_trace;
+    std::uint64_t m_trace_first_frame{1};
+    std::uint64_t m_trace_last_frame{0};
+};
+} // namespace st
@@ -1,8 +1,8 @@
 module;
 
-#include <any>
 #include <cassert>
-#include <functional>
+#include <cstddef>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -15,22 +15,37 @@ import :system_data;
 export namespace st {
 /**
  * @brief Wrapper around an arbitrary object as a system with callable methods
+ *
+ * Methods are dispatched through a static table of function pointers, one per system type.
+ * Small systems are stored in place, so systems only need to be constructible, not copyable or movable
  */
 template<typename context>
 class system_wrapper {
 public:
     template<typename sys, typename... args>
     system_wrapper(std::in_place_type_t<sys>, args &&...arguments)
-        : m_underlying{std::in_place_type<sys>, std::forward<args>(arguments)...} {
-        check_system_types<sys>();
+        : m_vtable{&vtable_of<std::decay_t<sys>>} {
+        using object_t = std::decay_t<sys>;
+        if constexpr(is_stored_in_place<object_t>) {
+            m_object = ::new(static_cast<void *>(m_storage)) object_t(std::forward<args>(arguments)...);
+        } else {
+            m_object = new object_t(std::forward<args>(arguments)...);
+        }
+    }
+    ~system_wrapper() {
+        m_vtable->destroy(m_object);
     }
+    system_wrapper(const system_wrapper &) = delete;
+    system_wrapper(system_wrapper &&) noexcept = delete;
+    system_wrapper &operator=(const system_wrapper &) = delete;
+    system_wrapper &operator=(system_wrapper &&) noexcept = delete;
 
     template<sys_type type, typename... args>
     sys_run_result call_method(args &&...arguments) {
 #define CHECK_AND_CALL(role) \
     if constexpr(type == sys_type::role) { \
-        assert(m_##role##_callback && "Not " #role " system"); \
-        return m_##role##_callback(std::forward<args>(arguments)...); \
+        assert(m_vtable->role != nullptr && "Not " #role " system"); \
+        return m_vtable->role(m_object, std::forward<args>(arguments)...); \
     }
         CHECK_AND_CALL(start)
         CHECK_AND_CALL(update)
@@ -42,107 +57,85 @@ public:
 #undef CHECK_AND_CALL
 
 private:
+    struct vtable {
+        void (*destroy)(void *);
+        sys_run_result (*update)(void *, seconds, context &);
+        sys_run_result (*start)(void *, context &);
+        sys_run_result (*cleanup)(void *, context &);
+        sys_run_result (*render)(void *, context &);
+        sys_run_result (*post_update)(void *, seconds, context &);
+        sys_run_result (*input)(void *, const event &, context &);
+    };
+
+    static constexpr std::size_t storage_size = 64;
+
     template<typename sys>
-    void check_system_types() {
-        auto *object = std::any_cast<std::decay_t<sys>>(&m_underlying);
+    static constexpr bool is_stored_in_place = sizeof(sys) <= storage_size && alignof(sys) <= alignof(std::max_align_t);
 
-        // Update
-        if constexpr(is_update_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().update(std::declval<seconds>(), std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_update_callback = [object](seconds delta, context &ctx) -> sys_run_result {
-                    return object->update(delta, ctx);
-                };
-            } else {
-                m_update_callback = [object](seconds delta, context &ctx) -> sys_run_result {
-                    object->update(delta, ctx);
-                    return sys_run_result::noop;
-                };
-            }
+    template<typename sys>
+    static void destroy(void *object) {
+        if constexpr(is_stored_in_place<sys>) {
+            static_cast<sys *>(object)->~sys();
+        } else {
+            delete static_cast<sys *>(object);
         }
+    }
 
-        // Post update
-        if constexpr(is_post_update_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().post_update(std::declval<seconds>(), std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_post_update_callback = [object](seconds delta, context &ctx) -> sys_run_result {
-                    return object->post_update(delta, ctx);
-                };
+    template<typename sys, sys_type type, typename... params>
+    static sys_run_result call(void *object, params... arguments) {
+        auto &system = *static_cast<sys *>(object);
+        const auto invoke = [&]() -> decltype(auto) {
+            if constexpr(type == sys_type::update) {
+                return system.update(arguments...);
+            } else if constexpr(type == sys_type::start) {
+                return system.start(arguments...);
+            } else if constexpr(type == sys_type::cleanup) {
+                return system.cleanup(arguments...);
+            } else if constexpr(type == sys_type::render) {
+                return system.render(arguments...);
+            } else if constexpr(type == sys_type::post_update) {
+                return system.post_update(arguments...);
             } else {
-                m_post_update_callback = [object](seconds delta, context &ctx) -> sys_run_result {
-                    object->post_update(delta, ctx);
-                    return sys_run_result::noop;
-                };
+                return system.input(arguments...);
             }
+        };
+        if constexpr(std::is_convertible_v<decltype(invoke()), sys_run_result>) {
+            return invoke();
+        } else {
+            invoke();
+            return sys_run_result::noop;
         }
+    }
 
-        // Start
+    template<typename sys>
+    static constexpr vtable make_vtable() {
+        vtable result{.destroy = &destroy<sys>};
+        if constexpr(is_update_system<sys, context>) {
+            result.update = &call<sys, sys_type::update, seconds, context &>;
+        }
         if constexpr(is_start_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().start(std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_start_callback = [object](context &ctx) -> sys_run_result {
-                    return object->start(ctx);
-                };
-            } else {
-                m_start_callback = [object](context &ctx) -> sys_run_result {
-                    object->start(ctx);
-                    return sys_run_result::noop;
-                };
-            }
+            result.start = &call<sys, sys_type::start, context &>;
+        }
+        if constexpr(is_cleanup_system<sys, context>) {
+            result.cleanup = &call<sys, sys_type::cleanup, context &>;
         }
-
-        // Render
         if constexpr(is_render_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().render(std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_render_callback = [object](context &ctx) -> sys_run_result {
-                    return object->render(ctx);
-                };
-            } else {
-                m_render_callback = [object](context &ctx) -> sys_run_result {
-                    object->render(ctx);
-                    return sys_run_result::noop;
-                };
-            }
+            result.render = &call<sys, sys_type::render, context &>;
         }
-
-        // Cleanup
-        if constexpr(is_cleanup_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().cleanup(std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_cleanup_callback = [object](context &ctx) -> sys_run_result {
-                    return object->cleanup(ctx);
-                };
-            } else {
-                m_cleanup_callback = [object](context &ctx) -> sys_run_result {
-                    object->cleanup(ctx);
-                    return sys_run_result::noop;
-                };
-            }
+        if constexpr(is_post_update_system<sys, context>) {
+            result.post_update = &call<sys, sys_type::post_update, seconds, context &>;
         }
-
-        // Input
         if constexpr(is_input_system<sys, context>) {
-            using return_t = decltype(std::declval<sys>().input(std::declval<const event &>(), std::declval<context &>()));
-            if constexpr(std::is_convertible_v<return_t, sys_run_result>) {
-                m_input_callback = [object](const event &ev, context &ctx) -> sys_run_result {
-                    return object->input(ev, ctx);
-                };
-            } else {
-                m_input_callback = [object](const event &ev, context &ctx) -> sys_run_result {
-                    object->input(ev, ctx);
-                    return sys_run_result::noop;
-                };
-            }
+            result.input = &call<sys, sys_type::input, const event &, context &>;
         }
+        return result;
     }
 
-    std::any m_underlying;
-    std::function<sys_run_result(seconds, context &)> m_update_callback;
-    std::function<sys_run_result(context &)> m_start_callback;
-    std::function<sys_run_result(context &)> m_cleanup_callback;
-    std::function<sys_run_result(context &)> m_render_callback;
-    std::function<sys_run_result(seconds, context &)> m_post_update_callback;
-    std::function<sys_run_result(const event &, context &)> m_input_callback;
+    template<typename sys>
+    static constexpr vtable vtable_of = make_vtable<sys>();
+
+    const vtable *m_vtable;
+    void *m_object{};
+    alignas(std::max_align_t) std::byte m_storage[storage_size];
 };
-} // namespace st
\ No newline at end of file
+} // namespace st
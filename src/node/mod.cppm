@@ -1,4 +1,6 @@
 export module stay3.node;
 
 export import :node;
+export import :prefab;
+export import :snapshot;
 export import :tree_context;
\ No newline at end of file
@@ -1,8 +1,12 @@
 module;
 
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <utility>
+#include <vector>
 
 module stay3.node;
 
@@ -16,6 +20,8 @@ node::node(tree_context &context)
     m_id = m_tree_context.get().register_node(*this);
     m_entities.on_create().connect<&node::entity_created_handler>(*this);
     m_entities.on_destroy().connect<&node::entity_destroyed_handler>(*this);
+    m_entities.on_create_batch().connect<&node::entities_created_handler>(*this);
+    m_entities.on_destroy_batch().connect<&node::entities_destroyed_handler>(*this);
 }
 
 node::~node() {
@@ -23,13 +29,7 @@ node::~node() {
 }
 
 node &node::add_child() {
-    // Constructor is private so no `std::make_unique`
-    auto child_ptr = std::unique_ptr<node>{new node{m_tree_context}};
-    auto &result = *child_ptr;
-    child_ptr->m_parent = this;
-    const auto id = child_ptr->m_id;
-    m_children.emplace(id, std::move(child_ptr));
-    return result;
+    return m_tree_context.get().create_node(*this);
 }
 
 node &node::parent() const {
@@ -41,59 +41,73 @@ bool node::is_root() const {
     return m_parent == nullptr;
 }
 
+std::uint32_t node::depth() const {
+    return m_tree_context.get().m_hierarchy[m_index].depth;
+}
+
 void node::reparent(node &other) {
     assert(this != &other && "Parent to self");
     assert(!is_ancestor_of(other) && "Cyclic relationship");
     assert(m_parent != nullptr && "Node does not have parent");
     assert(std::addressof(m_tree_context.get()) == std::addressof(other.m_tree_context.get())
            && "Nodes from 2 different trees");
-    // Remove from old parent
-    auto this_unique_ptr = std::move(m_parent->m_children[m_id]);
-    m_parent->m_children.erase(m_id);
-    // Append to new parent
     auto *old_parent = m_parent;
-    m_parent = &other;
-    other.m_children.emplace(m_id, std::move(this_unique_ptr));
+    m_tree_context.get().move_subtree(*this, other);
     m_tree_context.get().m_node_reparented.publish({.current = m_id, .old_parent = old_parent->m_id, .new_parent = m_parent->m_id});
 }
 
 bool node::is_ancestor_of(const node &other) const {
-    for(auto *i = other.m_parent; i != nullptr; i = i->m_parent) {
-        if(this == i) {
-            return true;
-        }
-    }
-    return false;
+    const auto &entry = m_tree_context.get().pre_order()[m_index];
+    return other.m_index > m_index && other.m_index < m_index + entry.subtree_size;
 }
 
 node &node::child(const id_type &id) const {
-    assert(m_children.contains(id) && "Not a child node");
-    return *m_children.at(id);
+    auto &result = m_tree_context.get().get_node(id);
+    assert(result.m_parent == this && "Not a child node");
+    return result;
 }
 
 void node::destroy_child(const id_type &id) {
-    assert(m_children.contains(id) && "Not a child node");
-    m_children.erase(id);
+    auto *const subtree = &child(id);
+    m_tree_context.get().tear_down(std::span{&subtree, 1});
+    m_tree_context.get().erase_subtree(*subtree);
 }
 
 void node::destroy_children() {
-    m_children.clear();
+    std::pmr::vector<node *> subtrees{m_tree_context.get().frame_memory()};
+    for(auto &child: *this) {
+        subtrees.push_back(&child);
+    }
+    m_tree_context.get().tear_down(subtrees);
+    // Erasing the last child first keeps positions of the others
+    for(auto it = subtrees.rbegin(); it != subtrees.rend(); ++it) {
+        m_tree_context.get().erase_subtree(**it);
+    }
 }
 
 node::const_iterator node::begin() const {
-    return m_children.cbegin();
+    const auto &hierarchy = m_tree_context.get().pre_order();
+    return hierarchy.data() + m_index + 1;
 }
 
 node::const_iterator node::end() const {
-    return m_children.cend();
+    const auto &hierarchy = m_tree_context.get().pre_order();
+    return hierarchy.data() + m_index + hierarchy[m_index].subtree_size;
 }
 
 node::iterator node::begin() {
-    return m_children.begin();
+    auto &hierarchy = m_tree_context.get().pre_order();
+    return hierarchy.data() + m_index + 1;
 }
 
 node::iterator node::end() {
-    return m_children.end();
+    auto &hierarchy = m_tree_context.get().pre_order();
+    return hierarchy.data() + m_index + hierarchy[m_index].subtree_size;
+}
+
+std::span<const node::flat_entry> node::subtree() const {
+    const auto &hierarchy = m_tree_context.get().pre_order();
+    return std::span{hierarchy}.subspan(m_index, hierarchy[m_index].subtree_size);
 }
 
 node::id_type node::id() const {
@@ -109,12 +123,34 @@ entities_holder &node::entities() {
 }
 
 void node::entity_created_handler(entity en) {
-    m_tree_context.get().add_entity_node_mapping(*this, en);
-    m_tree_context.get().m_entity_created.publish(*this, en);
+    auto &context = m_tree_context.get();
+    context.add_entity_node_mapping(*this, en);
+    context.m_hierarchy[m_index].first_entity = m_entities[0];
+    context.m_entity_created.publish(*this, en);
 }
 
 void node::entity_destroyed_handler(entity en) {
-    m_tree_context.get().m_entity_destroyed.publish(*this, en);
+    auto &context = m_tree_context.get();
+    // Only the last entity can be at index 0
+    if(m_entities.size() == 1) {
+        context.m_hierarchy[m_index].first_entity = {};
+    }
+    context.m_entity_destroyed.publish(*this, en);
+}
+
+void node::entities_created_handler(std::span<const entity> entities) {
+    auto &context = m_tree_context.get();
+    context.m_ecs_reg.insert<node_owner>(entities, node_owner{m_id});
+    for(const auto en: entities) {
+        context.m_entity_created.publish(*this, en);
+    }
+    context.m_hierarchy[m_index].first_entity = m_entities[0];
+}
+
+void node::entities_destroyed_handler(std::span<const entity> entities) {
+    auto &context = m_tree_context.get();
+    context.m_hierarchy[m_index].first_entity = {};
+    context.m_entities_destroyed.publish(entities);
 }
 
 } // namespace st
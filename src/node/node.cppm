@@ -1,9 +1,13 @@
 module;
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
-#include <unordered_map>
+#include <span>
+#include <type_traits>
+#include <vector>
 
 export module stay3.node:node;
 
@@ -15,50 +19,64 @@ export namespace st {
 class tree_context;
 class node {
 public:
+    /**
+     * @brief Generational id, so at most 2^20 nodes of a tree are alive at once
+     */
     using id_type = std::uint32_t;
 
-    class iterator {
-        using internal = std::unordered_map<id_type, std::unique_ptr<node>>::iterator;
+    /**
+     * @brief Entry of the pre-order flattened hierarchy owned by `tree_context`
+     *
+     * A subtree occupies `subtree_size` consecutive entries starting with its root
+     */
+    struct flat_entry {
+        static constexpr std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+        std::unique_ptr<node> handle;
+        std::uint32_t parent{no_parent};
+        std::uint32_t subtree_size{1};
+        // Number of ancestors, 0 for the root
+        std::uint32_t depth{};
+        entity first_entity;
+    };
 
+    class iterator {
     public:
-        iterator(internal it)
-            : m_it{it} {}
+        iterator(flat_entry *entry)
+            : m_entry{entry} {}
 
         node &operator*() {
-            return *m_it->second;
+            return *m_entry->handle;
         }
         iterator &operator++() {
-            ++m_it;
+            m_entry += m_entry->subtree_size;
             return *this;
         }
         bool operator==(const iterator &other) const {
-            return m_it == other.m_it;
+            return m_entry == other.m_entry;
         }
 
     private:
-        internal m_it;
+        flat_entry *m_entry;
     };
 
     class const_iterator {
-        using internal = std::unordered_map<id_type, std::unique_ptr<node>>::const_iterator;
-
     public:
-        const_iterator(internal it)
-            : m_it{it} {}
+        const_iterator(const flat_entry *entry)
+            : m_entry{entry} {}
 
         const node &operator*() const {
-            return *m_it->second;
+            return *m_entry->handle;
         }
         const_iterator &operator++() {
-            ++m_it;
+            m_entry += m_entry->subtree_size;
             return *this;
         }
         bool operator==(const const_iterator &other) const {
-            return m_it == other.m_it;
+            return m_entry == other.m_entry;
         }
 
     private:
-        internal m_it;
+        const flat_entry *m_entry;
     };
 
     ~node();
@@ -67,38 +85,64 @@ public:
     node &operator=(node &&) noexcept = delete;
     node &operator=(const node &) = delete;
 
+    /**
+     * @brief Adds a child after the existing ones
+     *
+     * O(depth) when this subtree ends the layout, as when building depth-first. Otherwise O(1), and the next call
+     * reading the pre-order layout (`subtree`, iteration, `reparent`, ...) rebuilds it once in O(N)
+     * @throw `std::length_error` if the tree already has 2^20 nodes
+     */
     node &add_child();
     [[nodiscard]] node &parent() const;
     [[nodiscard]] bool is_root() const;
+    /**
+     * @brief Number of ancestors, kept up to date by `add_child` and `reparent`
+     */
+    [[nodiscard]] std::uint32_t depth() const;
+    /**
+     * @brief Makes this node the last child of `other`, O(N) as entries between both positions shift
+     */
     void reparent(node &other);
     [[nodiscard]] bool is_ancestor_of(const node &other) const;
     [[nodiscard]] node &child(const id_type &id) const;
+    /**
+     * @brief Destroys the child and its subtree, O(N) as entries after the subtree shift
+     */
     void destroy_child(const id_type &id);
     void destroy_children();
 
     /**
-     * @brief Iterates over children nodes
+     * @brief Iterates over children nodes in insertion order
      */
     [[nodiscard]] const_iterator begin() const;
     [[nodiscard]] const_iterator end() const;
     iterator begin();
     iterator end();
+    /**
+     * @brief Entries of this node and its descendants in pre-order, this node first
+     * @note Invalidated by any change to the hierarchy
+     */
+    [[nodiscard]] std::span<const flat_entry> subtree() const;
     /**
      * @brief Apply `function` recursively, using parent's result as child's parameter
-     * @note Traversal is pre-order DFS. `ret`
+     * @note Traversal is pre-order DFS, a linear scan over `subtree()`. `function` must not change the hierarchy
      */
     template<typename func, typename... rets>
         requires(sizeof...(rets) == 0 || sizeof...(rets) == 1)
     void traverse(const func &function, const rets &...initials) {
+        const auto entries = subtree();
         if constexpr(sizeof...(rets) == 1) {
-            auto result = function(*this, initials...);
-            for(auto &&[id, ptr]: m_children) {
-                ptr->traverse(function, result);
+            using result_type = std::decay_t<decltype(function(*this, initials...))>;
+            std::vector<result_type> results;
+            results.reserve(entries.size());
+            results.push_back(function(*this, initials...));
+            for(std::size_t i = 1; i < entries.size(); ++i) {
+                const auto parent_offset = entries[i].parent - m_index;
+                results.push_back(function(*entries[i].handle, results[parent_offset]));
             }
         } else {
-            function(*this);
-            for(auto &&[id, ptr]: m_children) {
-                ptr->traverse(function);
+            for(const auto &entry: entries) {
+                function(*entry.handle);
             }
         }
     }
@@ -114,10 +158,13 @@ private:
     node(tree_context &context);
     void entity_created_handler(entity en);
     void entity_destroyed_handler(entity en);
+    void entities_created_handler(std::span<const entity> entities);
+    void entities_destroyed_handler(std::span<const entity> entities);
 
     id_type m_id{};
+    // Position in the flattened hierarchy
+    std::uint32_t m_index{};
     node *m_parent{};
-    std::unordered_map<id_type, std::unique_ptr<node>> m_children;
     std::reference_wrapper<tree_context> m_tree_context;
 
     entities_holder m_entities;
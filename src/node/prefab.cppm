@@ -0,0 +1,27 @@
+module;
+
+#include <cstddef>
+#include <span>
+
+export module stay3.node:prefab;
+
+import stay3.ecs;
+
+import :node;
+import :tree_context;
+
+export namespace st {
+/**
+ * @brief Creates `count` entities owned by `parent`, each with a copy of the components of `blueprint`
+ *
+ * Entities are created in bulk and components are emplaced in one batch per component type,
+ * so construct listeners see the whole instance
+ * @return Created entities, valid until the next modification of `parent`'s entities
+ */
+template<component... comps>
+std::span<const entity> instantiate(tree_context &ctx, node &parent, const prefab<comps...> &blueprint, std::size_t count) {
+    const auto entities = parent.entities().create_n(count);
+    blueprint.instantiate(ctx.ecs(), entities);
+    return entities;
+}
+} // namespace st
@@ -0,0 +1,133 @@
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+export module stay3.node:snapshot;
+
+import stay3.core;
+import stay3.ecs;
+
+import :node;
+import :tree_context;
+
+namespace st {
+constexpr std::uint32_t snapshot_magic = 0x33595453; // "STY3"
+constexpr std::uint32_t snapshot_version = 2;
+
+/**
+ * @brief Reads everything after the header into `ctx`, which must be empty
+ */
+template<snapshot_component... comps>
+void read_tree(tree_context &ctx, snapshot_reader &in) {
+    auto &reg = ctx.ecs();
+    ecs_snapshot_loader loader{reg, in};
+    loader.load_entities();
+
+    const auto node_count = in.read<std::uint64_t>();
+    std::vector<node *> nodes;
+    nodes.reserve(static_cast<std::size_t>(node_count));
+    for(std::uint64_t i = 0; i < node_count; ++i) {
+        const auto parent_index = in.read<std::uint32_t>();
+        if(i == 0) {
+            if(parent_index != node::flat_entry::no_parent) {
+                throw snapshot_error{"First node must be the root"};
+            }
+            nodes.push_back(&ctx.root());
+        } else {
+            if(parent_index >= nodes.size()) {
+                throw snapshot_error{"Node is saved before its parent"};
+            }
+            nodes.push_back(&nodes[parent_index]->add_child());
+        }
+        const auto entity_count = in.read<std::uint64_t>();
+        for(std::uint64_t j = 0; j < entity_count; ++j) {
+            const auto en = in.read_entity();
+            if(en.is_null() || reg.contains<node_owner>(en)) {
+                throw snapshot_error{"Entity is not owned by exactly one node"};
+            }
+            nodes.back()->entities().adopt(en);
+        }
+    }
+
+    loader.load_components<comps...>();
+}
+} // namespace st
+
+export namespace st {
+
+/**
+ * @brief Saves the node hierarchy, entity ownership and components of types `comps`
+ *
+ * Layout is header, entities, nodes in pre-order with their parent index and owned entities, then components
+ */
+template<snapshot_component... comps>
+void save_snapshot(tree_context &ctx, snapshot_writer &out) {
+    auto &reg = ctx.ecs();
+    out.write(snapshot_magic);
+    out.write(snapshot_version);
+    ecs_snapshot::save_entities(reg, out);
+
+    // The hierarchy is already in pre-order with parent indices
+    const auto hierarchy = ctx.hierarchy();
+    out.write(static_cast<std::uint64_t>(hierarchy.size()));
+    for(const auto &entry: hierarchy) {
+        out.write(entry.parent);
+        const auto &entities = entry.handle->entities();
+        out.write(static_cast<std::uint64_t>(entities.size()));
+        for(const auto en: entities) {
+            out.write(en);
+        }
+    }
+
+    ecs_snapshot::save_components<comps...>(reg, out);
+}
+
+/**
+ * @brief Replaces the content of `ctx` with a snapshot saved by `save_snapshot` with the same `comps`
+ *
+ * Ownership is restored before components are emplaced, so construct handlers can query the tree.
+ * The payload is read twice, once into a staging context to validate it and once into `ctx`
+ * @throw `snapshot_error` if the snapshot is malformed, `ctx` is left unchanged then
+ */
+template<snapshot_component... comps>
+void load_snapshot(tree_context &ctx, snapshot_reader &in) {
+    if(in.read<std::uint32_t>() != snapshot_magic) {
+        throw snapshot_error{"Not a snapshot"};
+    }
+    if(in.read<std::uint32_t>() != snapshot_version) {
+        throw snapshot_error{"Unsupported snapshot version"};
+    }
+    // Reading into a staging context first validates the whole payload, so a malformed snapshot keeps `ctx`
+    {
+        tree_context staging;
+        auto staged_in = in;
+        read_tree<comps...>(staging, staged_in);
+    }
+    ctx.destroy_tree();
+    read_tree<comps...>(ctx, in);
+}
+
+/**
+ * @throw `file_error` if the file cannot be written
+ */
+template<snapshot_component... comps>
+void save_snapshot(tree_context &ctx, const std::filesystem::path &path) {
+    snapshot_writer out;
+    save_snapshot<comps...>(ctx, out);
+    out.save(path);
+}
+
+/**
+ * @brief Loads a snapshot file by mapping it into memory and reading it sequentially
+ * @throw `file_error` if the file cannot be mapped, `snapshot_error` if it is malformed
+ */
+template<snapshot_component... comps>
+void load_snapshot(tree_context &ctx, const std::filesystem::path &path) {
+    const mapped_file file{path};
+    snapshot_reader in{file.data()};
+    load_snapshot<comps...>(ctx, in);
+}
+} // namespace st
@@ -1,10 +1,14 @@
 module;
 
+#include <algorithm>
 #include <cassert>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <memory_resource>
+#include <span>
 #include <utility>
+#include <vector>
 
 export module stay3.node:tree_context;
 
@@ -15,6 +19,15 @@ import :node;
 
 export namespace st {
 
+/**
+ * @brief Component of every entity owned by a node, holding the owner's id
+ *
+ * Managed by `tree_context`, it can be iterated alongside other components
+ */
+struct node_owner {
+    node::id_type id;
+};
+
 class tree_context {
 public:
     struct node_reparented_args {
@@ -31,12 +44,28 @@ public:
     decltype(auto) on_entity_destroyed() {
         return this->m_entity_destroyed_sink;
     }
+    /**
+     * @brief Signal before entities of whole subtrees are destroyed in bulk
+     *
+     * `on_entity_destroyed` is still published for each of them afterwards, only if it has listeners
+     */
+    decltype(auto) on_entities_destroyed() {
+        return this->m_entities_destroyed_sink;
+    }
 
     tree_context() {
-        m_ecs_reg.on_entity_destroyed().connect<&tree_context::remove_entity_node_mapping>(*this);
+        // Registered first, so `node_owner` is removed after other components of a destroyed entity
+        m_ecs_reg.on<comp_event::destroy, node_owner>().connect<&tree_context::remove_entity_node_mapping>(*this);
+    }
+    /**
+     * @param arena Backs `frame_memory`, it must outlive the context and is reset by the caller
+     */
+    explicit tree_context(frame_arena &arena)
+        : tree_context{} {
+        m_frame_arena = &arena;
     }
     ~tree_context() {
-        m_root.reset();
+        destroy_tree();
     }
     tree_context(const tree_context &) = delete;
     tree_context &operator=(const tree_context &) = delete;
@@ -44,17 +73,24 @@ public:
     tree_context &operator=(tree_context &&) noexcept = delete;
 
     [[nodiscard]] node &get_node(entity en) {
-        assert(m_entity_to_node.contains(en) && "Invalid entity");
-        return m_entity_to_node.at(en);
+        assert(m_ecs_reg.contains(en) && m_ecs_reg.contains<node_owner>(en) && "Invalid entity");
+        return get_node(m_ecs_reg.get<node_owner>(en)->id);
     }
 
     [[nodiscard]] ecs_registry &ecs() {
         return m_ecs_reg;
     }
 
+    /**
+     * @brief Whether `id` belongs to a node that still exists
+     */
+    [[nodiscard]] bool contains(const node::id_type &id) const {
+        return m_id_generator.is_alive(id);
+    }
+
     [[nodiscard]] const node &get_node(const node::id_type &id) const {
-        assert(m_id_to_node.contains(id) && "Unregistered id");
-        return m_id_to_node.at(id);
+        assert(contains(id) && "Unregistered or stale id");
+        return *m_id_to_node[node_id_generator::index_of(id)];
     }
 
     [[nodiscard]] node &get_node(const node::id_type &id) {
@@ -62,70 +98,302 @@ public:
     }
 
     [[nodiscard]] node &root() {
-        if(!m_root) {
+        if(m_hierarchy.empty()) {
             // We cannot use `std::make_unique` because the constructor is private
-            m_root = std::unique_ptr<node>{new node{*this}};
+            m_hierarchy.push_back({.handle = std::unique_ptr<node>{new node{*this}}});
         }
-        return *m_root;
+        return *m_hierarchy.front().handle;
+    }
+
+    /**
+     * @brief Whole tree in pre-order, the root is at index 0
+     * @note Rebuilds the layout in O(N) if nodes were added out of place since the last call
+     */
+    [[nodiscard]] std::span<const node::flat_entry> hierarchy() const {
+        return pre_order();
     }
 
     [[nodiscard]] any_map &vars() {
         return m_context_variables;
     }
 
+    /**
+     * @brief Memory for containers that do not outlive the current frame
+     *
+     * Backed by the arena given on construction, the default heap otherwise
+     */
+    [[nodiscard]] std::pmr::memory_resource *frame_memory() const {
+        return m_frame_arena != nullptr ? m_frame_arena->resource() : std::pmr::get_default_resource();
+    }
+
     void destroy_tree() {
-        if(m_root == nullptr) {
+        if(m_hierarchy.empty()) {
             return;
         }
-        // Destroy entities with respect to tree order
-        m_root->entities().clear();
-        m_root->destroy_children();
+        node *const root = m_hierarchy.front().handle.get();
+        tear_down(std::span{&root, 1});
         // Clear the registry together with stray entities
         m_ecs_reg.clear();
-        // Remove the root node
-        m_root.reset();
+        // Release the nodes after the hierarchy is empty
+        auto released = std::move(m_hierarchy);
+        m_hierarchy.clear();
+        m_is_layout_stale = false;
+        released.clear();
+    }
+
+    /**
+     * @brief Whether entities of whole subtrees are being destroyed in bulk
+     *
+     * Every node in such a subtree still owns its entities until the teardown ends
+     */
+    [[nodiscard]] bool is_tearing_down() const {
+        return m_is_tearing_down;
     }
 
 private:
     friend class node;
+    using node_id_generator = generational_id_generator<node::id_type>;
 
     void add_entity_node_mapping(node &node, entity en) {
-        m_entity_to_node.emplace(en, node);
+        m_ecs_reg.emplace<node_owner>(en, node.id());
+    }
+
+    void remove_entity_node_mapping(ecs_registry &, entity en) {
+        get_node(en).entities().discard(en);
+    }
+
+    /**
+     * @brief Destroys entities of `subtrees` at once, the nodes are left empty
+     */
+    void tear_down(std::span<node *const> subtrees) {
+        std::pmr::vector<node *> nodes{frame_memory()};
+        std::pmr::vector<entity> entities{frame_memory()};
+        for(auto *subtree: subtrees) {
+            subtree->traverse([&nodes, &entities](node &cur) {
+                nodes.push_back(&cur);
+                for(const auto en: cur.entities()) {
+                    entities.push_back(en);
+                }
+            });
+        }
+        if(entities.empty()) {
+            return;
+        }
+        m_entities_destroyed.publish(std::span<const entity>{entities});
+        if(!m_entity_destroyed.empty()) {
+            for(auto *cur: nodes) {
+                for(const auto en: cur->entities()) {
+                    m_entity_destroyed.publish(*cur, en);
+                }
+            }
+        }
+        for(auto *cur: nodes) {
+            cur->entities().begin_teardown();
+        }
+        m_is_tearing_down = true;
+        m_ecs_reg.destroy(std::span<const entity>{entities});
+        m_is_tearing_down = false;
+        for(auto *cur: nodes) {
+            cur->entities().end_teardown();
+            m_hierarchy[cur->m_index].first_entity = {};
+        }
+    }
+
+    /**
+     * @brief Adds a new node as the last child of `parent`
+     *
+     * If `parent` ends the layout, the node is appended in place in O(depth). Otherwise it is parked at the end and
+     * the layout is rebuilt once by the next call that needs pre-order, so a tree is built in O(N) in any order
+     */
+    node &create_node(node &parent) {
+        const auto position = static_cast<std::uint32_t>(m_hierarchy.size());
+        const auto is_in_place = !m_is_layout_stale && parent.m_index + m_hierarchy[parent.m_index].subtree_size == position;
+        // We cannot use `std::make_unique` because the constructor is private
+        auto handle = std::unique_ptr<node>{new node{*this}};
+        auto &result = *handle;
+        result.m_parent = &parent;
+        result.m_index = position;
+        m_hierarchy.push_back(
+            {.handle = std::move(handle), .parent = parent.m_index, .depth = m_hierarchy[parent.m_index].depth + 1});
+        if(is_in_place) {
+            resize_ancestors(&parent, 1);
+        } else {
+            m_is_layout_stale = true;
+        }
+        return result;
     }
 
-    void remove_entity_node_mapping(entity en) {
-        auto it = m_entity_to_node.find(en);
-        const auto is_stray_entity = it == m_entity_to_node.end();
-        if(is_stray_entity) { return; }
-        node &owner = it->second;
-        owner.entities().discard(en);
-        m_entity_to_node.erase(it);
+    /**
+     * @brief Entries in pre-order, sorting parked nodes into place first
+     *
+     * Parked nodes only have their index, parent index and depth set. Children are gathered per parent in layout
+     * order, where parked nodes come last in creation order, so siblings keep their insertion order
+     */
+    std::vector<node::flat_entry> &pre_order() const {
+        if(!m_is_layout_stale) {
+            return m_hierarchy;
+        }
+        m_is_layout_stale = false;
+        const auto count = m_hierarchy.size();
+        std::vector<std::uint32_t> child_offsets(count + 1);
+        for(std::size_t i = 1; i < count; ++i) {
+            ++child_offsets[m_hierarchy[i].parent + 1];
+        }
+        for(std::size_t i = 1; i <= count; ++i) {
+            child_offsets[i] += child_offsets[i - 1];
+        }
+        std::vector<std::uint32_t> children(count);
+        auto cursors = child_offsets;
+        for(std::uint32_t i = 1; i < count; ++i) {
+            children[cursors[m_hierarchy[i].parent]++] = i;
+        }
+
+        std::vector<node::flat_entry> sorted;
+        sorted.reserve(count);
+        std::vector<std::uint32_t> stack{0};
+        while(!stack.empty()) {
+            const auto current = stack.back();
+            stack.pop_back();
+            sorted.push_back(std::move(m_hierarchy[current]));
+            // Pushed in reverse so the first child is visited first
+            for(auto i = child_offsets[current + 1]; i > child_offsets[current]; --i) {
+                stack.push_back(children[i - 1]);
+            }
+        }
+        m_hierarchy = std::move(sorted);
+
+        for(std::uint32_t i = 0; i < count; ++i) {
+            auto &entry = m_hierarchy[i];
+            entry.handle->m_index = i;
+            entry.subtree_size = 1;
+        }
+        for(auto i = static_cast<std::uint32_t>(count); i-- > 1;) {
+            auto &entry = m_hierarchy[i];
+            entry.parent = entry.handle->m_parent->m_index;
+            m_hierarchy[entry.parent].subtree_size += entry.subtree_size;
+        }
+        return m_hierarchy;
+    }
+
+    /**
+     * @brief Moves the range of `subtree` right after the last descendant of `new_parent`, O(N) in the worst case
+     */
+    void move_subtree(node &subtree, node &new_parent) {
+        pre_order();
+        const auto first = subtree.m_index;
+        const auto size = m_hierarchy[first].subtree_size;
+        const auto target = new_parent.m_index + m_hierarchy[new_parent.m_index].subtree_size;
+        const auto depth_delta = static_cast<std::int64_t>(m_hierarchy[new_parent.m_index].depth) + 1 - m_hierarchy[first].depth;
+        resize_ancestors(subtree.m_parent, -static_cast<std::int64_t>(size));
+        resize_ancestors(&new_parent, size);
+        subtree.m_parent = &new_parent;
+
+        const auto begin = m_hierarchy.begin();
+        auto new_first = target;
+        if(target > first) {
+            // Entries between the subtree and `target` shift back
+            std::rotate(begin + first, begin + first + size, begin + target);
+            new_first = target - size;
+            reindex(first, target, [first, size, target, new_first](std::uint32_t index) {
+                if(index >= first && index < first + size) {
+                    return index - first + new_first;
+                }
+                return index >= first + size && index < target ? index - size : index;
+            });
+        } else {
+            std::rotate(begin + target, begin + first, begin + first + size);
+            reindex(target, first + size, [first, size, target](std::uint32_t index) {
+                if(index >= first && index < first + size) {
+                    return index - first + target;
+                }
+                return index >= target && index < first ? index + size : index;
+            });
+        }
+        m_hierarchy[new_first].parent = new_parent.m_index;
+        for(auto it = begin + new_first; it != begin + new_first + size; ++it) {
+            it->depth = static_cast<std::uint32_t>(it->depth + depth_delta);
+        }
+    }
+
+    /**
+     * @brief Removes the range of `subtree`, its entities must have been destroyed, O(N) in the worst case
+     */
+    void erase_subtree(node &subtree) {
+        pre_order();
+        const auto first = subtree.m_index;
+        const auto size = m_hierarchy[first].subtree_size;
+        resize_ancestors(subtree.m_parent, -static_cast<std::int64_t>(size));
+        const auto begin = m_hierarchy.begin() + first;
+        std::vector<std::unique_ptr<node>> released;
+        released.reserve(size);
+        for(auto it = begin; it != begin + size; ++it) {
+            released.push_back(std::move(it->handle));
+        }
+        m_hierarchy.erase(begin, begin + size);
+        reindex(first, static_cast<std::uint32_t>(m_hierarchy.size()), [first, size](std::uint32_t index) {
+            return index >= first + size ? index - size : index;
+        });
+        // Nodes unregister themselves once the hierarchy is consistent again
+    }
+
+    void resize_ancestors(node *ancestor, std::int64_t delta) {
+        for(; ancestor != nullptr; ancestor = ancestor->m_parent) {
+            auto &size = m_hierarchy[ancestor->m_index].subtree_size;
+            size = static_cast<std::uint32_t>(size + delta);
+        }
+    }
+
+    /**
+     * @brief Refreshes node indices of entries in [first, last) and maps parent indices from `first` on
+     *
+     * Entries after `last` keep their position but may have a parent inside the range.
+     * `new_index_of` maps an index from before the change to the current one, without touching the nodes
+     */
+    template<typename remap>
+    void reindex(std::uint32_t first, std::uint32_t last, const remap &new_index_of) {
+        for(auto i = first; i < last; ++i) {
+            m_hierarchy[i].handle->m_index = i;
+        }
+        for(auto i = first; i < m_hierarchy.size(); ++i) {
+            auto &parent = m_hierarchy[i].parent;
+            if(parent != node::flat_entry::no_parent) {
+                parent = new_index_of(parent);
+            }
+        }
     }
 
     [[nodiscard]] node::id_type register_node(node &node) {
         const auto new_id = m_id_generator.create();
-        m_id_to_node.emplace(new_id, node);
+        m_id_to_node.resize(m_id_generator.capacity());
+        m_id_to_node[node_id_generator::index_of(new_id)] = &node;
         return new_id;
     }
 
     void unregister_node(const node::id_type &id) {
-        assert(m_id_to_node.contains(id) && "Node was not registered");
-        m_id_to_node.erase(id);
+        assert(contains(id) && "Node was not registered");
+        m_id_to_node[node_id_generator::index_of(id)] = nullptr;
+        m_id_generator.recycle(id);
     }
 
-    std::unique_ptr<node> m_root;
-    std::unordered_map<node::id_type, std::reference_wrapper<node>> m_id_to_node;
-    id_generator<node::id_type> m_id_generator;
+    frame_arena *m_frame_arena{};
+    // Pre-order, so every subtree is a contiguous range, apart from parked nodes at the end while stale
+    mutable std::vector<node::flat_entry> m_hierarchy;
+    mutable bool m_is_layout_stale{};
+    // Indexed by the index part of node ids
+    std::vector<node *> m_id_to_node;
+    node_id_generator m_id_generator;
 
     signal<void(node_reparented_args)> m_node_reparented;
     sink<decltype(m_node_reparented)> m_node_reparented_sink{m_node_reparented};
 
     ecs_registry m_ecs_reg;
-    std::unordered_map<entity, std::reference_wrapper<node>, entity_hasher, entity_equal> m_entity_to_node;
     signal<void(node &, entity)> m_entity_created;
     sink<decltype(m_entity_created)> m_entity_created_sink{m_entity_created};
     signal<void(node &, entity)> m_entity_destroyed;
     sink<decltype(m_entity_destroyed)> m_entity_destroyed_sink{m_entity_destroyed};
+    signal<void(std::span<const entity>)> m_entities_destroyed;
+    sink<decltype(m_entities_destroyed)> m_entities_destroyed_sink{m_entities_destroyed};
+    bool m_is_tearing_down{};
 
     any_map m_context_variables;
 };
@@ -2,7 +2,6 @@ module;
 
 #include <cassert>
 #include <functional>
-#include <ranges>
 #include <vector>
 // clang-format off
 #include <Jolt/Jolt.h>
@@ -58,7 +57,7 @@ struct debug_draw {};
 export class physics_debug_drawer: public JPH::DebugRenderer {
 public:
     physics_debug_drawer(tree_context &ctx)
-        : m_tree_context{ctx} {
+        : m_tree_context{ctx}, m_commands{ctx.ecs()} {
         JPH::DebugRenderer::Initialize();
     };
 
@@ -127,20 +126,20 @@ public:
         auto &reg = m_tree_context.get().ecs();
         auto camera_en = reg.view<main_camera>().front();
         m_camera_position = reg.get<global_transform>(camera_en)->get().position();
-        const auto visible_entities = std::ranges::to<std::vector<entity>>(reg.view<rendered_mesh, debug_draw>());
-        for(auto en: visible_entities) {
-            reg.destroy<rendered_mesh>(en);
+        for(auto en: reg.view<rendered_mesh, debug_draw>()) {
+            m_commands.destroy_if_exist<rendered_mesh>(en);
         }
+        m_commands.playback();
     }
     void reset_cache() {
         auto &reg = m_tree_context.get().ecs();
-        auto visual_entities = std::ranges::to<std::vector<entity>>(reg.view<debug_draw>());
-        for(auto en: visual_entities) {
-            reg.destroy(en);
+        for(auto en: reg.view<debug_draw>()) {
+            m_commands.destroy_if_exist(en);
         }
         for(auto [unused, en]: m_material_entities) {
-            reg.destroy(en);
+            m_commands.destroy_if_exist(en);
         }
+        m_commands.playback();
         m_material_entities.clear();
     }
 
@@ -172,6 +171,7 @@ private:
 
     Batch m_empty_batch;
     std::reference_wrapper<tree_context> m_tree_context;
+    ecs_command_buffer m_commands;
 
     vec3f m_camera_position;
     std::unordered_map<color_hash, entity> m_material_entities;
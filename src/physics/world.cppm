@@ -182,9 +182,8 @@ public:
         while(m_pending_time > time_per_update) {
             m_pending_time -= time_per_update;
             const auto active_bodies_count = m_physics_system.GetNumActiveBodies(JPH::EBodyType::RigidBody);
-            JPH::BodyIDVector this_update_bodies_list;
-            m_physics_system.GetActiveBodies(JPH::EBodyType::RigidBody, this_update_bodies_list);
-            for(auto body: this_update_bodies_list) {
+            m_physics_system.GetActiveBodies(JPH::EBodyType::RigidBody, m_active_bodies);
+            for(auto body: m_active_bodies) {
                 m_bodies_with_changed_state.insert(body);
             }
 
@@ -327,6 +326,8 @@ private:
     }
     JPH::PhysicsSystem m_physics_system;
     std::unordered_set<body_id> m_bodies_with_changed_state;
+    // Reused by every update to keep its capacity
+    JPH::BodyIDVector m_active_bodies;
     // Mandatory objects to use JPH::PhysicsSystem
     layer::object_object_filter m_object_object_filter;
     broad_phase::layer_impl m_broad_phase_layer;
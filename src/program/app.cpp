@@ -34,6 +34,10 @@ system_manager<tree_context> &app::systems() {
     return m_ecs_systems;
 }
 
+system_profiler &app::profiler() {
+    return m_ecs_systems.profiler();
+}
+
 app &app::enable_default_systems() {
     m_ecs_systems
         .add<transform_sync_system>()
@@ -96,6 +100,7 @@ void app::on_frame() {
     m_pending_time += elapsed_time;
     while(m_pending_time > m_time_per_update) {
         m_pending_time -= m_time_per_update;
+        m_ecs_systems.profiler().next_frame();
         if(input() == window_closed::yes) {
             return;
         };
@@ -104,6 +109,7 @@ void app::on_frame() {
             return;
         }
         render();
+        m_frame_arena.reset();
     }
 }
 
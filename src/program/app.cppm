@@ -22,6 +22,10 @@ public:
     app(app &&) noexcept = delete;
     app &operator=(app &&) noexcept = delete;
     system_manager<tree_context> &systems();
+    /**
+     * @brief Per-system timings, recorded when stay3 is built with `stay3_ENABLE_PROFILER`
+     */
+    system_profiler &profiler();
     void run();
 
 private:
@@ -49,7 +53,9 @@ private:
     glfw_window m_window;
 
     system_manager<tree_context> m_ecs_systems;
-    tree_context m_tree_context;
+    // Reset after every frame, outlives the tree
+    frame_arena m_frame_arena;
+    tree_context m_tree_context{m_frame_arena};
     app_config m_config;
 };
 } // namespace st
@@ -1,9 +1,9 @@
 module;
 
 #include <cassert>
+#include <cstddef>
 #include <memory>
-#include <ranges>
-#include <vector>
+#include <span>
 // Needed for `ecs::registry::get` structured binding
 #include <tuple>
 // Needed for `std::unordered_set` ranged for loop
@@ -18,19 +18,16 @@ import stay3.physics;
 import stay3.system.transform;
 
 namespace st {
-/** @brief Tag to prevent transform changes from changing physics state of an entity */
+/** @brief Tracker tag to prevent transform changes from changing physics state of an entity */
 struct no_update_physics_state {};
-/** @brief Tag for entities of which physics state needs to be updated from transform */
+/** @brief Tracker tag for entities of which physics state needs to be updated from transform */
 struct update_physics_state_from_transform {};
 
 export class physics_system {
 public:
     physics_system(const physics_config &settings = {})
         : m_config{settings} {}
-    // Currently system wrapper impl uses `std::any` which requires copy ctor for no real benefit
-    physics_system(const physics_system &) {
-        assert(false && "Cannot copy");
-    }
+    physics_system(const physics_system &) = delete;
     physics_system(physics_system &&) noexcept = delete;
     physics_system &operator=(const physics_system &) = delete;
     physics_system &operator=(physics_system &&) noexcept = delete;
@@ -44,17 +41,18 @@ public:
 
     void update(seconds delta, tree_context &ctx) {
         auto &reg = ctx.ecs();
-        // We need to copy the view to fixed vector because iteration may invalidate it
-        const auto bodies_need_change = std::ranges::to<std::vector<entity>>(
-            reg.view<update_physics_state_from_transform>());
-        for(auto en: bodies_need_change) {
-            reg.emplace<no_update_physics_state>(en);
+        auto &pending = reg.tracker<update_physics_state_from_transform>();
+        auto &suppressed = reg.tracker<no_update_physics_state>();
+        // Syncing may mark more entities, index based loop picks them up as well
+        for(std::size_t i = 0; i < pending.size(); ++i) {
+            const auto en = pending.changed()[i];
+            suppressed.mark(en);
             const auto &id = *reg.get<physics_world::body_id>(en);
             const auto &global_tf = sync_global_transform(ctx, en).get();
             m_world->set_transform(id, global_tf.position(), global_tf.orientation());
-            reg.destroy<update_physics_state_from_transform>(en);
         }
-        reg.destroy_all<no_update_physics_state>();
+        pending.clear();
+        suppressed.clear();
 
         for(auto [en, collection]: reg.each<mut<collision_enter>>()) {
             collection->clear();
@@ -69,10 +67,10 @@ public:
 
         for(const auto &id: m_world->bodies_with_changed_state()) {
             auto en = m_world->entity(id);
-            reg.emplace<no_update_physics_state>(en);
+            suppressed.mark(en);
             set_global_transform(ctx, en, m_world->transform(id));
         }
-        reg.destroy_all<no_update_physics_state>();
+        suppressed.clear();
     }
 
     void render(tree_context &) {
@@ -96,8 +94,8 @@ private:
             .connect<&physics_system::on_collider_construct>(m_on_collider_construct_args);
         reg.on<comp_event::destroy, collider>().connect<&physics_system::on_collider_destroy>();
         reg.on<comp_event::destroy, physics_world::body_id>().connect<&physics_system::on_body_id_destroy>(*this);
-        reg.on<comp_event::update, global_transform>().connect<&physics_system::on_actual_global_transform_update>();
-        reg.on<comp_event::update, transform>().connect<&physics_system::on_actual_global_transform_update>();
+        reg.on_batch<comp_event::update, global_transform>().connect<&physics_system::on_actual_global_transform_update>();
+        reg.on_batch<comp_event::update, transform>().connect<&physics_system::on_actual_global_transform_update>();
         reg.on<comp_event::update, rigidbody>().connect<+[](ecs_registry &, entity) {
             assert(false && "Rigidbody changes are not supported");
         }>();
@@ -131,6 +129,7 @@ private:
     }
 
     static void on_collider_destroy(ecs_registry &reg, entity en) {
+        reg.tracker<update_physics_state_from_transform>().unmark(en);
         reg.destroy_if_exist<physics_world::body_id>(en);
         reg.destroy_if_exist<motion>(en);
         reg.destroy_if_exist<collision_exit>(en);
@@ -142,9 +141,13 @@ private:
         m_world->destroy(*reg.get<physics_world::body_id>(en));
     }
 
-    static void on_actual_global_transform_update(ecs_registry &reg, entity en) {
-        if(reg.contains<physics_world::body_id>(en) && !reg.contains<no_update_physics_state>(en)) {
-            reg.emplace_if_not_exist<update_physics_state_from_transform>(en);
+    static void on_actual_global_transform_update(ecs_registry &reg, std::span<const entity> entities) {
+        auto &pending = reg.tracker<update_physics_state_from_transform>();
+        const auto &suppressed = reg.tracker<no_update_physics_state>();
+        for(auto en: entities) {
+            if(reg.contains<physics_world::body_id>(en) && !suppressed.contains(en)) {
+                pending.mark(en);
+            }
         }
     }
 
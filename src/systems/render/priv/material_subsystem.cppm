@@ -15,7 +15,6 @@ import :bind_group_layouts;
 
 namespace st {
 
-struct material_state_update_pending {};
 
 export class material_subsystem {
 public:
@@ -29,19 +28,16 @@ public:
 
     void process_pending_materials(tree_context &ctx) {
         auto &reg = ctx.ecs();
-        for(auto en: reg.view<material_state_update_pending>()) {
+        for(auto en: reg.each<changed<material>, material_subsystem>()) {
             update_material_state(reg, en);
         }
-        reg.destroy_all<material_state_update_pending>();
     }
 
 private:
     static void setup_signals(tree_context &ctx) {
         auto &reg = ctx.ecs();
         make_hard_dependency<material_state, material>(reg);
-        reg.on<comp_event::construct, material>().connect<&ecs_registry::emplace<material_state_update_pending>>();
-        reg.on<comp_event::update, material>().connect<&ecs_registry::emplace_if_not_exist<material_state_update_pending>>();
-        reg.on<comp_event::destroy, material>().connect<&ecs_registry::destroy_if_exist<material_state_update_pending>>();
+        reg.watch<changed<material>, material_subsystem>();
     }
 
     [[nodiscard]] wgpu::Buffer create_properties_buffer() const {
@@ -1,6 +1,7 @@
 module;
 
 #include <cassert>
+#include <type_traits>
 #include <webgpu/webgpu_cpp.h>
 
 export module stay3.system.render.priv:mesh_subsystem;
@@ -14,32 +15,49 @@ import :components;
 
 namespace st {
 
-struct mesh_builder_data_changed {};
-struct mesh_data_update_requested {};
-struct mesh_data_changed {};
+/**
+ * @brief Reader of the reactive filters of `mesh_subsystem`
+ */
+struct mesh_reader {};
 
 template<typename builder>
 void register_one_mesh_builder(ecs_registry &reg) {
-    reg.on<comp_event::construct, builder>().template connect<&ecs_registry::emplace<mesh_builder_data_changed>>();
-    reg.on<comp_event::update, builder>().template connect<&ecs_registry::emplace_if_not_exist<mesh_builder_data_changed>>();
-    reg.on<comp_event::destroy, builder>().template connect<&ecs_registry::destroy_if_exist<mesh_builder_data_changed>>();
-    reg.on<comp_event::construct, mesh_data_update_requested>().connect<+[](ecs_registry &reg, entity en) {
-        // This callback is invoked for every builder type so we need to do this check
-        if(reg.contains<builder>(en)) {
-            if constexpr(std::is_same_v<builder, mesh_sprite_builder>) {
-                reg.emplace_or_replace<mesh_data>(en, reg.get<builder>(en)->build(reg));
-            } else {
-                reg.emplace_or_replace<mesh_data>(en, reg.get<builder>(en)->build());
-            }
-        }
-    }>();
+    reg.watch<changed<builder>, mesh_reader>();
 }
 
-export template<typename... builders>
-void register_mesh_builders(ecs_registry &reg) {
-    (register_one_mesh_builder<builders>(reg), ...);
+template<typename builder>
+void build_changed_meshes(ecs_registry &reg) {
+    for(auto en: reg.each<changed<builder>, mesh_reader>()) {
+        if constexpr(std::is_same_v<builder, mesh_sprite_builder>) {
+            reg.emplace_or_replace<mesh_data>(en, reg.get<builder>(en)->build(reg));
+        } else {
+            reg.emplace_or_replace<mesh_data>(en, reg.get<builder>(en)->build());
+        }
+    }
 }
 
+/**
+ * @brief Builders handled by `mesh_subsystem`, each one is watched, rebuilt and checked in the same place
+ */
+template<typename... builders>
+struct mesh_builder_list {
+    static void register_all(ecs_registry &reg) {
+        (register_one_mesh_builder<builders>(reg), ...);
+    }
+    static void build_changed(ecs_registry &reg) {
+        (build_changed_meshes<builders>(reg), ...);
+    }
+    static bool has_builder(ecs_registry &reg, entity en) {
+        return (reg.contains<builders>(en) || ...);
+    }
+};
+
+using default_mesh_builders = mesh_builder_list<
+    mesh_plane_builder,
+    mesh_sprite_builder,
+    mesh_cube_builder,
+    mesh_uv_sphere_builder>;
+
 export class mesh_subsystem {
 public:
     void start(tree_context &tree_ctx, init_result &graphics_context) {
@@ -50,35 +68,23 @@ public:
     void process_pending_meshes(tree_context &ctx) {
         auto &reg = ctx.ecs();
 
-        for(auto en: reg.view<mesh_builder_data_changed>()) {
-            reg.emplace<mesh_data_update_requested>(en);
-        }
-        reg.destroy_all<mesh_builder_data_changed>();
-        reg.destroy_all<mesh_data_update_requested>();
-
-        for(auto en: reg.view<mesh_data_changed>()) {
+        default_mesh_builders::build_changed(reg);
+        for(auto en: reg.each<changed<mesh_data>, mesh_reader>()) {
             update_mesh_state_from_data(reg, en);
         }
-        reg.destroy_all<mesh_data_changed>();
     }
 
     [[nodiscard]] static bool has_mesh(ecs_registry &reg, entity en) {
-        return reg.contains<mesh_data>(en) || reg.contains<mesh_builder_data_changed>(en);
+        return reg.contains<mesh_data>(en) || default_mesh_builders::has_builder(reg, en);
     }
 
 private:
     static void setup_signals(tree_context &ctx) {
         auto &reg = ctx.ecs();
         make_hard_dependency<mesh_state, mesh_data>(reg);
-        reg.on<comp_event::construct, mesh_data>().connect<&ecs_registry::emplace<mesh_data_changed>>();
-        reg.on<comp_event::update, mesh_data>().connect<&ecs_registry::emplace_if_not_exist<mesh_data_changed>>();
-        reg.on<comp_event::destroy, mesh_data>().connect<&ecs_registry::destroy_if_exist<mesh_data_changed>>();
-
-        register_mesh_builders<
-            mesh_plane_builder,
-            mesh_sprite_builder,
-            mesh_cube_builder,
-            mesh_uv_sphere_builder>(reg);
+        reg.watch<changed<mesh_data>, mesh_reader>();
+
+        default_mesh_builders::register_all(reg);
     }
     void update_mesh_state_from_data(ecs_registry &reg, entity en) const {
         auto [state, data] = reg.get<mut<mesh_state>, mesh_data>(en);
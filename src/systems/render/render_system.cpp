@@ -1,8 +1,9 @@
 module;
 
 #include <algorithm>
+#include <cstddef>
 #include <filesystem>
-#include <type_traits>
+#include <memory_resource>
 #include <variant>
 #include <webgpu/webgpu_cpp.h>
 
@@ -50,7 +51,7 @@ void render_system::render(tree_context &ctx) {
     {
         auto cameras = reg.each<camera, main_camera, global_transform>();
         assert(cameras.begin() != cameras.end() && "No main camera found");
-        auto [unused_en, cam, unused_tag, tf] = *cameras.begin();
+        auto [cam_en, cam, unused_tag, tf] = *cameras.begin();
         cam_position = tf->get().position();
         assert(cam->ratio.has_value() && "Camera aspect was not set by system");
         clear_color = cam->clear_color;
@@ -63,8 +64,9 @@ void render_system::render(tree_context &ctx) {
                     return orthographic(ortho.width, cam->ratio.value(), cam->near, cam->far);
                 }},
             cam->data);
-        const auto camera_view_projection = camera_projection * tf->get().inv_matrix();
-        update_all_object_uniforms(reg, camera_view_projection);
+        // Exact even when a parent of the camera introduces shear
+        const auto camera_view_projection = camera_projection * global_matrix(ctx, cam_en).inv();
+        update_all_object_uniforms(ctx, camera_view_projection);
     }
     // Draw commands
     const auto &&[unused, encoder, render_pass_encoder] = create_render_pass(m_global.device, m_global.surface, m_depth_texture.view, clear_color);
@@ -116,15 +118,24 @@ void render_system::cleanup(tree_context &) const {
     m_global.surface.Unconfigure();
 }
 
-void render_system::update_all_object_uniforms(ecs_registry &reg, const mat4f &camera_view_projection) {
+void render_system::update_all_object_uniforms(tree_context &ctx, const mat4f &camera_view_projection) {
+    auto &reg = ctx.ecs();
     assert(std::ranges::all_of(reg.each<rendered_mesh_state>(), [&reg](const auto &tuple) {
                return reg.contains<global_transform>(std::get<0>(tuple));
            })
            && "rendered_mesh_state without global_transform");
-    for(auto &&[unused, global_tf, state]: reg.each<global_transform, rendered_mesh_state>()) {
-        const auto &mat = global_tf->get().matrix();
-        static_assert(std::is_same_v<std::decay_t<decltype(mat)>, mat4f>);
-        const mat4f mvp_matrix_uniform = camera_view_projection * global_tf->get().matrix();
+    // `rendered_mesh` is sorted every frame so only its state is owned
+    auto objects = reg.group<rendered_mesh_state>(get<global_transform>);
+    std::pmr::vector<entity> entities{ctx.frame_memory()};
+    for(auto &&[en, state, global_tf]: objects) {
+        entities.push_back(en);
+    }
+    // World matrices only exist in this array for the duration of the frame
+    std::pmr::vector<mat4f> world_matrices{entities.size(), ctx.frame_memory()};
+    global_matrices(ctx, entities, world_matrices);
+    std::size_t index = 0;
+    for(auto &&[unused, state, global_tf]: objects) {
+        const mat4f mvp_matrix_uniform = camera_view_projection * world_matrices[index++];
         static_assert(sizeof(mvp_matrix_uniform) % 4 == 0, "Not a multiple of 4");
         m_global.queue.WriteBuffer(state->object_uniform_buffer, 0, &mvp_matrix_uniform, sizeof(mvp_matrix_uniform));
     }
@@ -140,11 +151,6 @@ void render_system::setup_signals(tree_context &ctx) {
 
     make_soft_dependency<transform, camera>(reg);
     reg.on<comp_event::construct, camera>().connect<&render_system::fix_camera_aspect>(ctx);
-
-    register_mesh_builders<
-        mesh_plane_builder,
-        mesh_sprite_builder,
-        mesh_cube_builder>(reg);
 }
 
 void render_system::fix_camera_aspect(tree_context &ctx, ecs_registry &reg, entity en) {
@@ -22,7 +22,7 @@ public:
     void cleanup(tree_context &) const;
 
 private:
-    void update_all_object_uniforms(ecs_registry &reg, const mat4f &camera_view_projection);
+    void update_all_object_uniforms(tree_context &ctx, const mat4f &camera_view_projection);
     void setup_signals(tree_context &ctx);
 
     static void fix_camera_aspect(tree_context &ctx, ecs_registry &reg, entity en);
@@ -3,7 +3,6 @@ module;
 export module stay3.system.text.priv:text_state;
 
 export namespace st {
-struct text_data_changed {};
 struct text_state {
 };
 } // namespace st
\ No newline at end of file
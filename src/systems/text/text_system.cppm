@@ -29,13 +29,12 @@ public:
     }
     static void render(tree_context &ctx) {
         auto &reg = ctx.ecs();
-        for(auto en: reg.view<text_data_changed>()) {
+        for(auto en: reg.each<changed<text>, text_system>()) {
             build_text_geometry(ctx, reg, en);
             if(!reg.contains<rendered_mesh>(en)) {
                 initialize_rendered_mesh(reg, en);
             }
         }
-        reg.destroy_all<text_data_changed>();
     }
 
 private:
@@ -70,9 +69,7 @@ private:
         }>();
     }
     static void track_text_changes(ecs_registry &reg) {
-        reg.on<comp_event::construct, text>().connect<&ecs_registry::emplace_if_not_exist<text_data_changed>>();
-        reg.on<comp_event::update, text>().connect<&ecs_registry::emplace_if_not_exist<text_data_changed>>();
-        reg.on<comp_event::destroy, text>().connect<&ecs_registry::destroy_if_exist<text_data_changed>>();
+        reg.watch<changed<text>, text_system>();
     }
     static void create_mesh_with_text(ecs_registry &reg) {
         reg.on<comp_event::construct, text>().connect<+[](ecs_registry &reg, entity en) {
@@ -106,9 +103,14 @@ private:
         const auto max_character_count = txt->content.length();
         auto &vertices = mesh->vertices;
         auto &indices = mesh->maybe_indices;
+        // Keep capacity of the previous geometry
         vertices.clear();
         vertices.reserve(max_character_count * 4);
-        indices.emplace();
+        if(indices.has_value()) {
+            indices->clear();
+        } else {
+            indices.emplace();
+        }
         constexpr auto indices_per_quad = 6;
         indices->reserve(max_character_count * indices_per_quad);
         auto pen_x = 0.F;
@@ -1,8 +1,10 @@
 module;
 
 #include <cassert>
-#include <cstdint>
-#include <unordered_map>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
 
 module stay3.system.transform;
 
@@ -14,40 +16,88 @@ struct dirty_flag {};
 
 namespace st {
 
+/**
+ * @brief Levels with fewer dirty transforms are synced on the calling thread
+ */
+constexpr std::size_t parallel_sync_threshold = 1024;
+
+change_tracker &dirty_transforms(ecs_registry &reg) {
+    return reg.tracker<dirty_flag>();
+}
+
+/**
+ * @brief Dirty entities grouped by depth of their node
+ *
+ * A parent transform is always in a lower level than its dependents, so levels are synced in order.
+ * Entries unmarked since they were added are skipped, and so are entries left behind in an old level by a reparent,
+ * which lists the entity again at its new depth
+ */
+struct dirty_levels {
+    std::vector<std::vector<entity>> levels;
+};
+
+dirty_levels &dirty_transform_levels(tree_context &ctx) {
+    if(auto *levels = ctx.vars().find<dirty_levels>(); levels != nullptr) {
+        return *levels;
+    }
+    return ctx.vars().emplace<dirty_levels>();
+}
+
+/**
+ * @brief Owning group keeping local and global transforms packed in the same order
+ */
+auto transforms_group(ecs_registry &reg) {
+    return reg.group<transform, mut<global_transform>>();
+}
+
+void mark_dirty(tree_context &ctx, entity en) {
+    if(!dirty_transforms(ctx.ecs()).mark(en)) {
+        return;
+    }
+    const auto depth = ctx.get_node(en).depth();
+    auto &levels = dirty_transform_levels(ctx).levels;
+    if(depth >= levels.size()) {
+        levels.resize(depth + 1);
+    }
+    levels[depth].push_back(en);
+}
+
 void mark_subtree_dirty(tree_context &ctx, entity en) {
     auto &reg = ctx.ecs();
+    auto &dirty = dirty_transforms(reg);
     assert(reg.contains<transform>(en));
     const auto &node = ctx.get_node(en);
 
     if(node.entities()[0] != en) {
-        reg.emplace_if_not_exist<dirty_flag>(en);
+        mark_dirty(ctx, en);
         return;
     }
-    if(reg.contains<dirty_flag>(en)) {
+    if(dirty.contains(en)) {
         return;
     }
 
-    constexpr auto children_needs_mark = [](ecs_registry &reg, const class node &node) {
+    constexpr auto children_needs_mark = [](ecs_registry &reg, const change_tracker &dirty, const class node &node) {
         if(node.entities().is_empty()) { return false; }
         return reg.contains<transform>(node.entities()[0])
-               && !reg.contains<dirty_flag>(node.entities()[0]);
+               && !dirty.contains(node.entities()[0]);
     };
-    constexpr auto traverse_tree = [children_needs_mark](auto &&self, ecs_registry &reg, const class node &node) -> void {
-        const auto will_mark_children = children_needs_mark(reg, node);
+    constexpr auto traverse_tree = [children_needs_mark](auto &&self, tree_context &ctx, change_tracker &dirty, const class node &node) -> void {
+        auto &reg = ctx.ecs();
+        const auto will_mark_children = children_needs_mark(reg, dirty, node);
         for(auto en: node.entities()) {
             if(reg.contains<transform>(en)) {
-                reg.emplace_if_not_exist<dirty_flag>(en);
+                mark_dirty(ctx, en);
             }
         }
         if(will_mark_children) {
             for(const auto &child_node: node) {
-                self(self, reg, child_node);
+                self(self, ctx, dirty, child_node);
             }
         };
     };
-    reg.emplace<dirty_flag>(en);
+    mark_dirty(ctx, en);
     for(const auto &child: node) {
-        traverse_tree(traverse_tree, reg, child);
+        traverse_tree(traverse_tree, ctx, dirty, child);
     }
 }
 
@@ -64,11 +114,24 @@ void mark_subtree_dirty_except_root(tree_context &ctx, entity en) {
 
 void node_reparented_handler(tree_context &ctx, tree_context::node_reparented_args args) {
     const auto &node = ctx.get_node(args.current);
+    // Depths in the subtree changed, so dirty entities are listed again at their new level
+    auto &dirty = dirty_transforms(ctx.ecs());
+    std::pmr::vector<entity> was_dirty{ctx.frame_memory()};
+    for(const auto &entry: node.subtree()) {
+        for(auto en: entry.handle->entities()) {
+            if(dirty.unmark(en)) {
+                was_dirty.push_back(en);
+            }
+        }
+    }
     for(auto en: node.entities()) {
         if(ctx.ecs().contains<transform>(en)) {
             mark_subtree_dirty(ctx, en);
         }
     }
+    for(auto en: was_dirty) {
+        mark_dirty(ctx, en);
+    }
 }
 
 void transform_constructed_handler(tree_context &ctx, ecs_registry &, entity en) {
@@ -79,15 +142,18 @@ void transform_constructed_handler(tree_context &ctx, ecs_registry &, entity en)
 
 void transform_destroyed_handler(tree_context &ctx, ecs_registry &, entity en) {
     auto &reg = ctx.ecs();
-    if(en == ctx.get_node(en).entities()[0]) {
+    // Descendants are destroyed in the same teardown
+    if(!ctx.is_tearing_down() && en == ctx.get_node(en).entities()[0]) {
         mark_subtree_dirty_except_root(ctx, en);
     }
-    reg.destroy_if_exist<global_transform>(en);
-    reg.destroy_if_exist<dirty_flag>(en);
+    reg.destroy_if_exist<global_transform, sheared_global_matrix>(en);
+    dirty_transforms(reg).unmark(en);
 }
 
-void transform_updated_handler(tree_context &ctx, ecs_registry &, entity en) {
-    mark_subtree_dirty(ctx, en);
+void transform_updated_handler(tree_context &ctx, ecs_registry &, std::span<const entity> entities) {
+    for(auto en: entities) {
+        mark_subtree_dirty(ctx, en);
+    }
 }
 
 const transform &global_transform::get() const {
@@ -99,9 +165,10 @@ void transform_sync_system::start(tree_context &ctx) {
 
     reg.on<comp_event::construct, transform>().connect<&transform_constructed_handler>(ctx);
     reg.on<comp_event::destroy, transform>().connect<&transform_destroyed_handler>(ctx);
-    reg.on<comp_event::update, transform>().connect<&transform_updated_handler>(ctx);
+    reg.on_batch<comp_event::update, transform>().connect<&transform_updated_handler>(ctx);
 
     ctx.on_node_reparented().connect<&node_reparented_handler>(ctx);
+    static_cast<void>(transforms_group(reg));
     log::info("Transform sync system started");
 }
 
@@ -109,60 +176,131 @@ void transform_sync_system::post_update(seconds, tree_context &ctx) {
     sync_global_transform(ctx);
 }
 
-void sync_global_transform(tree_context &ctx) {
-    std::unordered_map<node::id_type, std::uint32_t> ancestor_count;
+/**
+ * @brief Entity whose global transform `en` is relative to, or null for origin
+ * @note Only reads the registry and the hierarchy
+ */
+entity parent_transform_entity(tree_context &ctx, entity en) {
+    const auto &node = ctx.get_node(en);
+    if(node.is_root() || node.parent().entities().is_empty()) {
+        return {};
+    }
+    const auto parent_en = node.parent().entities()[0];
+    return ctx.ecs().contains<global_transform>(parent_en) ? parent_en : entity{};
+}
+
+/**
+ * @brief World matrix of `en`, whose global transform is up to date
+ */
+mat4f synced_global_matrix(ecs_registry &reg, entity en) {
+    if(reg.contains<sheared_global_matrix>(en)) {
+        return reg.get<sheared_global_matrix>(en)->matrix;
+    }
+    return reg.get<global_transform>(en)->get().matrix();
+}
+
+/**
+ * @brief Whether `local` under the synced `parent_en` needs `sheared_global_matrix`
+ * @param any_sheared Whether some entity has `sheared_global_matrix`, usually false
+ */
+bool needs_shear(ecs_registry &reg, entity parent_en, const transform &local, bool any_sheared) {
+    return !parent_en.is_null()
+           && ((any_sheared && reg.contains<sheared_global_matrix>(parent_en))
+               || !transform::combines_exactly(reg.get<global_transform>(parent_en)->get(), local));
+}
+
+/**
+ * @brief Sets `global` of `en` from `local` and the synced `parent_en`, adding or removing `sheared_global_matrix` as needed
+ */
+void combine_global(ecs_registry &reg, entity en, entity parent_en, const transform &local, transform &global, bool any_sheared) {
+    if(needs_shear(reg, parent_en, local, any_sheared)) {
+        const mat4f world = synced_global_matrix(reg, parent_en) * local.matrix();
+        global.set_matrix(world);
+        reg.emplace_or_replace<sheared_global_matrix>(en, world);
+        return;
+    }
+    if(any_sheared) {
+        reg.destroy_if_exist<sheared_global_matrix>(en);
+    }
+    if(parent_en.is_null()) {
+        global = local;
+    } else {
+        global.set_combined(reg.get<global_transform>(parent_en)->get(), local);
+    }
+}
 
-    ctx.root().traverse(
-        [&ancestor_count](const node &cur, std::uint32_t count) {
-            ancestor_count.emplace(cur.id(), count);
-            return count + 1;
-        },
-        0);
+void sync_global_transform(tree_context &ctx) {
+    sync_global_transform(ctx, default_thread_pool());
+}
 
+void sync_global_transform(tree_context &ctx, thread_pool &pool) {
     auto &reg = ctx.ecs();
-    reg.sort<dirty_flag>([&ctx, &ancestor_count](entity prev, entity later) {
-        return ancestor_count[ctx.get_node(prev).id()] < ancestor_count[ctx.get_node(later).id()];
-    });
+    auto transforms = transforms_group(reg);
+    auto &dirty = dirty_transforms(reg);
+    std::pmr::vector<entity> pending{ctx.frame_memory()};
+    std::pmr::vector<entity> exact{ctx.frame_memory()};
 
-    for(auto &&[en, unused]: reg.each<dirty_flag>()) {
-        const auto &node = ctx.get_node(en);
-        if(!reg.contains<transform>(en)) {
-            continue;
+    auto &levels = dirty_transform_levels(ctx).levels;
+    for(std::size_t depth = 0; depth < levels.size(); ++depth) {
+        // Entities marked by listeners from now on are synced in the next call
+        pending.clear();
+        for(const auto en: levels[depth]) {
+            if(!dirty.contains(en) || ctx.get_node(en).depth() != depth) {
+                continue;
+            }
+            if(dirty.unmark(en) && reg.contains<transform>(en)) {
+                pending.push_back(en);
+            }
         }
-        auto [local, global] = reg.get<transform, mut<global_transform>>(en);
-        const auto has_parent_transform =
-            !node.is_root()
-            && !node.parent().entities().is_empty()
-            && reg.contains<global_transform>(node.parent().entities()[0]);
-        if(!has_parent_transform) {
-            global->global = *local;
+        levels[depth].clear();
+        // Only this level gains the component from here on, and parents are in lower levels
+        const auto any_sheared = !reg.is_empty<sheared_global_matrix>();
+
+        if(pending.size() < parallel_sync_threshold || pool.thread_count() == 1) {
+            for(const auto en: pending) {
+                auto [local, global] = transforms.get(en);
+                combine_global(reg, en, parent_transform_entity(ctx, en), *local, global->global, any_sheared);
+            }
             continue;
         }
-        auto parent_global = reg.get<global_transform>(node.parent().entities()[0]);
-        global->global.set_matrix(parent_global->global.matrix() * local->matrix());
+        // Workers must not add or remove components, so the rare sheared transforms are synced here
+        exact.clear();
+        for(const auto en: pending) {
+            const auto parent_en = parent_transform_entity(ctx, en);
+            if(needs_shear(reg, parent_en, *reg.get<transform>(en), any_sheared)) {
+                auto [local, global] = transforms.get(en);
+                combine_global(reg, en, parent_en, *local, global->global, any_sheared);
+            } else {
+                if(any_sheared) {
+                    reg.destroy_if_exist<sheared_global_matrix>(en);
+                }
+                exact.push_back(en);
+            }
+        }
+        // Entities of one level are independent, `parallel_for` returning is the barrier between levels
+        reg.par_each<transform, mut<global_transform>>(pool, exact, [&ctx, &reg](entity en, auto local, auto global) {
+            const auto parent_en = parent_transform_entity(ctx, en);
+            if(parent_en.is_null()) {
+                global->global = *local;
+            } else {
+                global->global.set_combined(reg.get<global_transform>(parent_en)->get(), *local);
+            }
+        });
     }
-    reg.destroy_all<dirty_flag>();
 }
 
 const global_transform &sync_global_transform(tree_context &ctx, entity en) {
     auto &reg = ctx.ecs();
-    if(!reg.contains<dirty_flag>(en)) {
+    if(!dirty_transforms(reg).contains(en)) {
         return *reg.get<global_transform>(en);
     }
-    const auto &node = ctx.get_node(en);
-    const auto has_parent_transform =
-        !node.is_root()
-        && !node.parent().entities().is_empty()
-        && reg.contains<global_transform>(node.parent().entities()[0]);
-    auto [local, global] = reg.get<transform, mut<global_transform>>(en);
-    if(!has_parent_transform) {
-        global->global = *local;
-    } else {
-        auto parent_en = node.parent().entities()[0];
-        const auto &parent_global = sync_global_transform(ctx, parent_en);
-        global->global.set_matrix(parent_global.global.matrix() * local->matrix());
+    const auto parent_en = parent_transform_entity(ctx, en);
+    if(!parent_en.is_null()) {
+        sync_global_transform(ctx, parent_en);
     }
-    reg.destroy<dirty_flag>(en);
+    auto [local, global] = reg.get<transform, mut<global_transform>>(en);
+    combine_global(reg, en, parent_en, *local, global->global, !reg.is_empty<sheared_global_matrix>());
+    dirty_transforms(reg).unmark(en);
     return *reg.get<global_transform>(en);
 }
 
@@ -175,16 +313,45 @@ void set_global_transform(tree_context &ctx, entity en, const transform &value)
         && !my_node.parent().entities().is_empty()
         && reg.contains<transform>(my_node.parent().entities()[0]);
     const auto is_independent = !parent_has_tf || en != my_node.entities()[0];
+    reg.destroy_if_exist<sheared_global_matrix>(en);
     if(is_independent) {
         *reg.get<mut<transform>>(en) = value;
         reg.get<mut<global_transform>>(en)->global = value;
-        reg.destroy_if_exist<dirty_flag>(en);
+        dirty_transforms(reg).unmark(en);
         return;
     }
-    const auto &parent_tf = sync_global_transform(ctx, my_node.parent().entities()[0]).get();
-    reg.get<mut<transform>>(en)->set_matrix(parent_tf.inv_matrix() * value.matrix());
+    const auto parent_en = my_node.parent().entities()[0];
+    sync_global_transform(ctx, parent_en);
+    const auto parent_inv = reg.contains<sheared_global_matrix>(parent_en)
+                                ? reg.get<sheared_global_matrix>(parent_en)->matrix.inv()
+                                : reg.get<global_transform>(parent_en)->get().inv_matrix();
+    reg.get<mut<transform>>(en)->set_matrix(parent_inv * value.matrix());
     reg.get<mut<global_transform>>(en)->global = value;
-    reg.destroy_if_exist<dirty_flag>(en);
+    dirty_transforms(reg).unmark(en);
+}
+
+mat4f global_matrix(tree_context &ctx, entity en) {
+    sync_global_transform(ctx, en);
+    return synced_global_matrix(ctx.ecs(), en);
+}
+
+void global_matrices(tree_context &ctx, std::span<const entity> entities, std::span<mat4f> out) {
+    assert(entities.size() == out.size() && "Mismatched sizes");
+    auto &reg = ctx.ecs();
+    std::pmr::vector<const transform *> globals{ctx.frame_memory()};
+    globals.reserve(entities.size());
+    for(const auto en: entities) {
+        globals.push_back(&reg.get<global_transform>(en)->get());
+    }
+    compute_matrices(globals, out);
+    if(reg.is_empty<sheared_global_matrix>()) {
+        return;
+    }
+    for(std::size_t i = 0; i < entities.size(); ++i) {
+        if(reg.contains<sheared_global_matrix>(entities[i])) {
+            out[i] = reg.get<sheared_global_matrix>(entities[i])->matrix;
+        }
+    }
 }
 
-} // namespace st
\ No newline at end of file
+} // namespace st
@@ -1,3 +1,7 @@
+module;
+
+#include <span>
+
 export module stay3.system.transform;
 
 import stay3.core;
@@ -17,11 +21,22 @@ public:
 
 private:
     friend void sync_global_transform(tree_context &);
+    friend void sync_global_transform(tree_context &, thread_pool &);
     friend const global_transform &sync_global_transform(tree_context &, entity);
     friend void set_global_transform(tree_context &, entity, const transform &);
     transform global;
 };
 
+/**
+ * @brief Exact world matrix of an entity whose global transform has shear
+ *
+ * Only present while `transform::combines_exactly` fails for the entity and its parent, or the parent has one itself.
+ * `global_transform` then holds the closest transform without shear
+ */
+struct sheared_global_matrix {
+    mat4f matrix;
+};
+
 class transform_sync_system {
 public:
     static void start(tree_context &ctx);
@@ -29,10 +44,17 @@ public:
 };
 
 /**
- * @brief Sync all `global_transform` based on local `transform`
+ * @brief Sync all `global_transform` based on local `transform`, on `default_thread_pool`
  */
 void sync_global_transform(tree_context &ctx);
 
+/**
+ * @brief Same as above, levels of the hierarchy with many dirty transforms are split across `pool`
+ *
+ * Update events of `global_transform` computed in parallel are published in a batch after their level
+ */
+void sync_global_transform(tree_context &ctx, thread_pool &pool);
+
 /**
  * @brief Sync single `global_transform`
  */
@@ -40,4 +62,14 @@ const global_transform &sync_global_transform(tree_context &ctx, entity en);
 
 void set_global_transform(tree_context &ctx, entity en, const transform &value);
 
+/**
+ * @brief Synced world matrix of `en`, exact even with shear
+ */
+mat4f global_matrix(tree_context &ctx, entity en);
+
+/**
+ * @brief Writes world matrices of `entities` to `out` in batches, their global transforms must be synced
+ */
+void global_matrices(tree_context &ctx, std::span<const entity> entities, std::span<mat4f> out);
+
 } // namespace st
\ No newline at end of file
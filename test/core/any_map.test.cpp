@@ -1,4 +1,11 @@
+#include <any>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 import stay3.core;
@@ -78,4 +85,54 @@ TEST_CASE("any_map modification", "[any_map]") {
         REQUIRE(map.get<std::vector<int>>().size() == 4);
         REQUIRE(map.get<std::vector<int>>()[3] == 20);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("any_map lookup", "[any_map]") {
+    st::any_map map;
+
+    SECTION("find returns null for missing types") {
+        REQUIRE(map.find<int>() == nullptr);
+        map.emplace<int>(5);
+        REQUIRE(map.find<int>() == &map.get<int>());
+        map.erase<int>();
+        REQUIRE(map.find<int>() == nullptr);
+    }
+
+    SECTION("Move-only types") {
+        map.emplace<std::unique_ptr<int>>(std::make_unique<int>(3));
+        REQUIRE(*map.get<std::unique_ptr<int>>() == 3);
+    }
+
+    SECTION("Variables keep their address") {
+        const auto *address = &map.emplace<int>(1);
+        map.emplace<float>(2.F);
+        map.emplace<std::string>("grow");
+        REQUIRE(&map.get<int>() == address);
+    }
+}
+
+TEST_CASE("any_map benchmark", "[.][benchmark]") {
+    struct runtime_info {
+        std::size_t frame;
+    };
+    constexpr int lookup_count = 100'000;
+
+    std::unordered_map<std::type_index, std::any> hashed;
+    hashed.emplace(std::type_index{typeid(runtime_info)}, std::make_any<runtime_info>(runtime_info{1}));
+    st::any_map map;
+    map.emplace<runtime_info>(runtime_info{1});
+
+    BENCHMARK("Hashed type_index and any_cast") {
+        std::size_t sum{};
+        for(int i = 0; i < lookup_count; ++i) {
+            sum += std::any_cast<runtime_info &>(hashed.at(std::type_index{typeid(runtime_info)})).frame;
+        }
+        return sum;
+    };
+    BENCHMARK("any_map get") {
+        std::size_t sum{};
+        for(int i = 0; i < lookup_count; ++i) {
+            sum += map.get<runtime_info>().frame;
+        }
+        return sum;
+    };
+}
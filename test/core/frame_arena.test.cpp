@@ -0,0 +1,132 @@
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+import stay3.core;
+import stay3.node;
+
+using namespace st;
+
+namespace {
+/**
+ * @brief Heap resource counting its allocations, installed as the default resource
+ */
+class counting_resource: public std::pmr::memory_resource {
+public:
+    std::size_t allocations{};
+
+private:
+    void *do_allocate(std::size_t size, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(size, alignment);
+    }
+    void do_deallocate(void *pointer, std::size_t size, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+    }
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+} // namespace
+
+TEST_CASE("Frame arena") {
+    SECTION("Allocations fitting the buffer stay off the heap") {
+        frame_arena arena{1024};
+        std::pmr::vector<int> values{arena.resource()};
+        values.reserve(16);
+        for(int i = 0; i < 16; ++i) {
+            values.push_back(i);
+        }
+        REQUIRE(values.back() == 15);
+        REQUIRE(arena.overflow_count() == 0);
+    }
+
+    SECTION("Overflow grows the buffer on reset") {
+        constexpr std::size_t initial_capacity = 64;
+        constexpr std::size_t count = 1000;
+        frame_arena arena{initial_capacity};
+        auto *const resource = arena.resource();
+        const auto fill = [&arena] {
+            std::pmr::vector<std::size_t> values{arena.resource()};
+            values.reserve(count);
+            for(std::size_t i = 0; i < count; ++i) {
+                values.push_back(i);
+            }
+            return values.back();
+        };
+
+        REQUIRE(fill() == count - 1);
+        REQUIRE(arena.overflow_count() > 0);
+        arena.reset();
+        REQUIRE(arena.overflow_count() == 0);
+        REQUIRE(arena.capacity() >= count * sizeof(std::size_t));
+        REQUIRE(arena.resource() == resource);
+
+        REQUIRE(fill() == count - 1);
+        REQUIRE(arena.overflow_count() == 0);
+    }
+}
+
+TEST_CASE("Frame memory of tree context") {
+    SECTION("Default heap without arena") {
+        tree_context ctx;
+        REQUIRE(ctx.frame_memory() == std::pmr::get_default_resource());
+    }
+
+    SECTION("Given arena") {
+        frame_arena arena;
+        tree_context ctx{arena};
+        REQUIRE(ctx.frame_memory() == arena.resource());
+
+        auto &root = ctx.root();
+        for(int i = 0; i < 8; ++i) {
+            root.add_child().entities().create();
+        }
+        root.destroy_children();
+        REQUIRE(root.begin() == root.end());
+        REQUIRE(arena.overflow_count() == 0);
+    }
+}
+
+TEST_CASE("Heap allocations of a frame") {
+    counting_resource heap;
+    auto *const previous = std::pmr::set_default_resource(&heap);
+    frame_arena arena;
+
+    // Subtree teardown builds its node and entity lists in frame memory
+    const auto teardown_frame = [&heap, &arena](tree_context &ctx) {
+        constexpr int children = 64;
+        constexpr int entities_per_child = 8;
+        auto &root = ctx.root();
+        for(int i = 0; i < children; ++i) {
+            auto &child = root.add_child();
+            for(int j = 0; j < entities_per_child; ++j) {
+                static_cast<void>(child.entities().create());
+            }
+        }
+        const auto before = heap.allocations;
+        root.destroy_children();
+        const auto allocations = heap.allocations - before + arena.overflow_count();
+        arena.reset();
+        return allocations;
+    };
+    std::size_t without_arena{};
+    std::size_t with_arena{};
+    {
+        tree_context ctx;
+        static_cast<void>(teardown_frame(ctx));
+        without_arena = teardown_frame(ctx);
+    }
+    {
+        tree_context ctx{arena};
+        // The first frame may grow the arena
+        static_cast<void>(teardown_frame(ctx));
+        with_arena = teardown_frame(ctx);
+    }
+    std::pmr::set_default_resource(previous);
+
+    INFO("Without arena: " << without_arena << ", with arena: " << with_arena);
+    REQUIRE(without_arena > 0);
+    REQUIRE(with_arena == 0);
+}
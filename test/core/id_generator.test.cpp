@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <unordered_set>
 #include <catch2/catch_all.hpp>
 import stay3;
@@ -34,3 +35,47 @@ TEST_CASE("id_generator basic functionality") {
         REQUIRE(created_ids.size() == mx);
     }
 }
+
+TEST_CASE("generational_id_generator") {
+    using generator_type = generational_id_generator<std::uint32_t>;
+    generator_type generator;
+
+    SECTION("Indices are dense") {
+        REQUIRE(generator_type::index_of(generator.create()) == 0);
+        REQUIRE(generator_type::index_of(generator.create()) == 1);
+        REQUIRE(generator.capacity() == 2);
+    }
+
+    SECTION("Recycled index gets a new generation") {
+        const auto first = generator.create();
+        generator.recycle(first);
+        const auto second = generator.create();
+        REQUIRE(first != second);
+        REQUIRE(generator_type::index_of(first) == generator_type::index_of(second));
+        REQUIRE(generator_type::generation_of(second) == generator_type::generation_of(first) + 1);
+        REQUIRE_FALSE(generator.is_alive(first));
+        REQUIRE(generator.is_alive(second));
+        REQUIRE(generator.capacity() == 1);
+    }
+
+    SECTION("Generation wraps around") {
+        auto id = generator.create();
+        for(std::uint32_t i = 0; i <= generator_type::generation_mask; ++i) {
+            generator.recycle(id);
+            id = generator.create();
+        }
+        REQUIRE(generator_type::generation_of(id) == 0);
+        REQUIRE(generator_type::index_of(id) == 0);
+    }
+
+    SECTION("Exceeding the live id limit throws") {
+        using short_generator_type = generational_id_generator<std::uint16_t>;
+        short_generator_type short_generator;
+        for(std::size_t i = 0; i < short_generator_type::max_alive; ++i) {
+            static_cast<void>(short_generator.create());
+        }
+        REQUIRE_THROWS_AS(short_generator.create(), std::length_error);
+        short_generator.recycle(0);
+        REQUIRE(short_generator_type::index_of(short_generator.create()) == 0);
+    }
+}
@@ -0,0 +1,75 @@
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+import stay3.core;
+
+TEST_CASE("Thread pool") {
+    const std::size_t thread_count = GENERATE(1, 2, 4);
+    st::thread_pool pool{thread_count};
+
+    SECTION("Every index is visited exactly once") {
+        constexpr std::size_t count = 10007;
+        std::vector<std::atomic<int>> visits(count);
+        // Assertions are not thread-safe, so workers only record what is checked afterwards
+        std::atomic<std::size_t> oversized_chunks{};
+        pool.parallel_for(count, 64, [&](std::size_t begin, std::size_t end) {
+            if(end - begin > 64) {
+                oversized_chunks.fetch_add(1, std::memory_order_relaxed);
+            }
+            for(auto i = begin; i < end; ++i) {
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        REQUIRE(oversized_chunks.load() == 0);
+        for(const auto &visit: visits) {
+            REQUIRE(visit.load() == 1);
+        }
+    }
+
+    SECTION("Empty range does not call function") {
+        bool called = false;
+        pool.parallel_for(0, [&](std::size_t, std::size_t) {
+            called = true;
+        });
+        REQUIRE_FALSE(called);
+    }
+
+    SECTION("Pool can be reused under contention") {
+        std::atomic<std::size_t> sum{};
+        for(int round = 0; round < 100; ++round) {
+            pool.parallel_for(1000, 1, [&](std::size_t begin, std::size_t end) {
+                for(auto i = begin; i < end; ++i) {
+                    sum.fetch_add(i, std::memory_order_relaxed);
+                }
+            });
+        }
+        REQUIRE(sum.load() == 100 * (999 * 1000 / 2));
+    }
+
+    SECTION("Nested loops run serially") {
+        std::atomic<int> visits{};
+        pool.parallel_for(8, 1, [&](std::size_t, std::size_t) {
+            pool.parallel_for(8, 1, [&](std::size_t, std::size_t) {
+                visits.fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+        REQUIRE(visits.load() == 64);
+    }
+
+    SECTION("Exceptions are rethrown") {
+        REQUIRE_THROWS_AS(pool.parallel_for(100, 1, [](std::size_t begin, std::size_t) {
+                              if(begin == 42) {
+                                  throw std::runtime_error{"Error"};
+                              }
+                          }),
+                          std::runtime_error);
+        std::atomic<int> visits{};
+        pool.parallel_for(10, 1, [&](std::size_t, std::size_t) {
+            visits.fetch_add(1, std::memory_order_relaxed);
+        });
+        REQUIRE(visits.load() == 10);
+    }
+}
@@ -48,3 +48,23 @@ TEST_CASE("stop_watch restart behavior") {
         REQUIRE(time_after_sleep <= (sleep_ms + acceptable_margin_ms) / ms_per_s);
     }
 }
+
+TEST_CASE("tick_watch") {
+    constexpr ticks ns_per_ms = 1000000;
+    tick_watch watch;
+
+    SECTION("Clock is monotonic") {
+        const auto first = tick_watch::now();
+        const auto second = tick_watch::now();
+        REQUIRE(second >= first);
+    }
+
+    SECTION("Restart after sleep should return elapsed ticks") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        REQUIRE(watch.elapsed() >= sleep_ms * ns_per_ms);
+        const auto ticks_after_sleep = watch.restart();
+        REQUIRE(ticks_after_sleep >= sleep_ms * ns_per_ms);
+        REQUIRE(ticks_after_sleep <= (sleep_ms + acceptable_margin_ms) * ns_per_ms);
+        REQUIRE(watch.elapsed() < ticks_after_sleep);
+    }
+}
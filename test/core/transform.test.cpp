@@ -168,4 +168,73 @@ TEST_CASE("Combined transform") {
         REQUIRE(same_orientation(tf.orientation(), quaternionf{vec_up, PI / 2}.rotate(vec_forward, -PI / 4)));
         REQUIRE(approx_equal(tf.scale(), vec3f{2.F, 2.F, 2.F}));
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Composition with parent") {
+    const transform local{vec3f{1.F, -2.F, 0.5F}, quaternionf{vec3f{1.F, 2.F, -1.F}.normalized(), 0.7F}, vec3f{0.5F, 2.F, 3.F}};
+    const quaternionf parent_orientation{vec3f{-3.F, 1.F, 2.F}.normalized(), 1.9F};
+    transform combined;
+
+    SECTION("Uniform parent scale") {
+        const transform parent{vec3f{4.F, 0.F, -1.F}, parent_orientation, vec3f{2.5F}};
+        combined.set_combined(parent, local);
+        REQUIRE(approx_equal(combined.matrix(), parent.matrix() * local.matrix()));
+        REQUIRE(approx_equal(combined.scale(), vec3f{1.25F, 5.F, 7.5F}));
+    }
+
+    SECTION("Negative uniform parent scale") {
+        const transform parent{vec3f{4.F, 0.F, -1.F}, parent_orientation, vec3f{-1.5F}};
+        combined.set_combined(parent, local);
+        REQUIRE(approx_equal(combined.matrix(), parent.matrix() * local.matrix()));
+    }
+
+    SECTION("Non-uniform parent scale without local rotation") {
+        const transform parent{vec3f{4.F, 0.F, -1.F}, parent_orientation, vec3f{1.F, 3.F, -2.F}};
+        const transform unrotated{local.position(), quaternionf{}, local.scale()};
+        REQUIRE(transform::combines_exactly(parent, unrotated));
+        combined.set_combined(parent, unrotated);
+        REQUIRE(approx_equal(combined.matrix(), parent.matrix() * unrotated.matrix()));
+    }
+
+    SECTION("Shear is dropped") {
+        const transform parent{vec3f{4.F, 0.F, -1.F}, parent_orientation, vec3f{1.F, 3.F, 2.F}};
+        REQUIRE_FALSE(transform::combines_exactly(parent, local));
+        combined.set_combined(parent, local);
+        const mat4f product = parent.matrix() * local.matrix();
+        REQUIRE(approx_equal(combined.position(), vec3f{product[3]}));
+        REQUIRE(approx_equal(combined.inv_matrix(), combined.matrix().inv()));
+    }
+}
+
+TEST_CASE("Compact layout") {
+    // Position, orientation and scale only, matrices are computed on request
+    STATIC_REQUIRE(sizeof(transform) == 10 * sizeof(float));
+}
+
+TEST_CASE("Analytic inverse") {
+    const transform tf{vec3f{-7.F, 2.F, 0.25F}, quaternionf{vec3f{0.F, 1.F, 3.F}.normalized(), 2.2F}, vec3f{0.5F, -4.F, 1.5F}};
+    REQUIRE(approx_equal(tf.inv_matrix(), tf.matrix().inv()));
+    REQUIRE(approx_equal(tf.matrix() * tf.inv_matrix(), mat4f{}));
+}
+
+TEST_CASE("Composition benchmark", "[.][benchmark]") {
+    const transform parent{vec3f{4.F, 0.F, -1.F}, quaternionf{vec3f{-3.F, 1.F, 2.F}.normalized(), 1.9F}, vec3f{2.F}};
+    const transform local{vec3f{1.F, -2.F, 0.5F}, quaternionf{vec3f{1.F, 2.F, -1.F}.normalized(), 0.7F}, vec3f{0.5F, 2.F, 3.F}};
+    transform combined;
+
+    BENCHMARK("Direct composition") {
+        combined.set_combined(parent, local);
+        return combined.position();
+    };
+    BENCHMARK("Matrix product and decomposition") {
+        combined.set_matrix(parent.matrix() * local.matrix());
+        return combined.position();
+    };
+    BENCHMARK("Analytic inverse") {
+        combined.set_combined(parent, local);
+        return combined.inv_matrix();
+    };
+    BENCHMARK("General inverse") {
+        combined.set_combined(parent, local);
+        return combined.matrix().inv();
+    };
+}
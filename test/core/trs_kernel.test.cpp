@@ -0,0 +1,85 @@
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <catch2/catch_all.hpp>
+import stay3;
+import stay3.test_helper;
+using namespace st;
+
+namespace {
+struct trs_arrays {
+    std::vector<vec3f> positions;
+    std::vector<quaternionf> orientations;
+    std::vector<vec3f> scales;
+};
+
+trs_arrays make_arrays(std::size_t count) {
+    trs_arrays result;
+    for(std::size_t i = 0; i < count; ++i) {
+        const auto value = static_cast<float>(i);
+        result.positions.emplace_back(value, -2.F * value, 0.5F);
+        const vec3f axis{vec3f{1.F, value, 2.F - value}.normalized()};
+        result.orientations.emplace_back(axis, 0.37F * value);
+        result.scales.emplace_back(1.F + value, 0.5F, i % 2 == 0 ? -1.F : 2.F);
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("Batched TRS kernel") {
+    // Not a multiple of the SIMD width, so the scalar tail runs as well
+    constexpr std::size_t count = 11;
+    const auto arrays = make_arrays(count);
+    std::vector<mat4f> batched(count);
+    std::vector<mat4f> reference(count);
+    compose_trs(arrays.positions, arrays.orientations, arrays.scales, batched);
+    compose_trs_scalar(arrays.positions, arrays.orientations, arrays.scales, reference);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        INFO(i);
+        const transform tf{arrays.positions[i], arrays.orientations[i], arrays.scales[i]};
+        REQUIRE(approx_equal(batched[i], reference[i]));
+        REQUIRE(approx_equal(reference[i], tf.matrix()));
+    }
+}
+
+TEST_CASE("Batched transform matrices") {
+    // More than one batch of `compute_matrices`
+    constexpr std::size_t count = 150;
+    const auto arrays = make_arrays(count);
+    std::vector<transform> transforms;
+    std::vector<const transform *> pointers;
+    transforms.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        transforms.emplace_back(arrays.positions[i], arrays.orientations[i], arrays.scales[i]);
+        pointers.push_back(&transforms.back());
+    }
+    std::vector<mat4f> matrices(count);
+    compute_matrices(pointers, matrices);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        INFO(i);
+        REQUIRE(approx_equal(matrices[i], transforms[i].matrix()));
+    }
+}
+
+TEST_CASE("Batched TRS kernel benchmark", "[.][benchmark]") {
+    constexpr std::size_t count = 10'000;
+    const auto arrays = make_arrays(count);
+    std::vector<mat4f> out(count);
+
+    BENCHMARK("Compose 10k matrices, batched") {
+        compose_trs(arrays.positions, arrays.orientations, arrays.scales, out);
+        return out.back()[3].x;
+    };
+    BENCHMARK("Compose 10k matrices, scalar reference") {
+        compose_trs_scalar(arrays.positions, arrays.orientations, arrays.scales, out);
+        return out.back()[3].x;
+    };
+    BENCHMARK("Compose 10k matrices, one transform at a time") {
+        for(std::size_t i = 0; i < count; ++i) {
+            out[i] = transform{arrays.positions[i], arrays.orientations[i], arrays.scales[i]}.matrix();
+        }
+        return out.back()[3].x;
+    };
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+import stay3.ecs;
+using Catch::Matchers::RangeEquals;
+using Catch::Matchers::UnorderedRangeEquals;
+
+struct tracked_tag {};
+struct other_tracked_tag {};
+
+TEST_CASE("Change tracker") {
+    st::ecs_registry reg;
+    auto &changes = reg.tracker<tracked_tag>();
+
+    SECTION("Same tag returns same tracker") {
+        REQUIRE(&changes == &reg.tracker<tracked_tag>());
+        REQUIRE(&changes != &reg.tracker<other_tracked_tag>());
+    }
+
+    SECTION("Mark and unmark") {
+        const auto en1 = reg.create();
+        const auto en2 = reg.create();
+        const auto en3 = reg.create();
+        REQUIRE(changes.is_empty());
+
+        REQUIRE(changes.mark(en1));
+        REQUIRE(changes.mark(en2));
+        REQUIRE_FALSE(changes.mark(en1));
+        REQUIRE(changes.size() == 2);
+        REQUIRE(changes.contains(en1));
+        REQUIRE_FALSE(changes.contains(en3));
+        REQUIRE_THAT(changes.changed(), RangeEquals(std::vector<st::entity>{en1, en2}, st::entity_equal{}));
+
+        REQUIRE(changes.unmark(en1));
+        REQUIRE_FALSE(changes.unmark(en1));
+        REQUIRE_FALSE(changes.contains(en1));
+        REQUIRE(changes.contains(en2));
+        REQUIRE_THAT(changes.changed(), RangeEquals(std::vector<st::entity>{en2}, st::entity_equal{}));
+
+        changes.mark(en3);
+        changes.clear();
+        REQUIRE(changes.is_empty());
+        REQUIRE_FALSE(changes.contains(en2));
+        REQUIRE_FALSE(changes.contains(en3));
+        REQUIRE(changes.mark(en2));
+    }
+
+    SECTION("Sort") {
+        std::vector<st::entity> entities;
+        for(int i = 0; i < 5; ++i) {
+            entities.push_back(reg.create());
+            changes.mark(entities.back());
+        }
+        changes.sort([](st::entity lhs, st::entity rhs) {
+            return lhs.numeric() > rhs.numeric();
+        });
+        REQUIRE_THAT(changes.changed(), RangeEquals(std::vector<st::entity>{entities.rbegin(), entities.rend()}, st::entity_equal{}));
+        REQUIRE(changes.unmark(entities[4]));
+        REQUIRE_THAT(changes.changed(), UnorderedRangeEquals(std::vector<st::entity>{entities[0], entities[1], entities[2], entities[3]}, st::entity_equal{}));
+    }
+
+    SECTION("Destroyed entities are removed") {
+        const auto en1 = reg.create();
+        const auto en2 = reg.create();
+        changes.mark(en1);
+        changes.mark(en2);
+        reg.tracker<other_tracked_tag>().mark(en1);
+
+        reg.destroy(en1);
+        REQUIRE_FALSE(changes.contains(en1));
+        REQUIRE_FALSE(reg.tracker<other_tracked_tag>().contains(en1));
+        REQUIRE_THAT(changes.changed(), RangeEquals(std::vector<st::entity>{en2}, st::entity_equal{}));
+
+        // Recycled entity does not inherit the mark
+        const auto en3 = reg.create();
+        REQUIRE_FALSE(changes.contains(en3));
+    }
+
+    SECTION("Registry clear clears trackers") {
+        changes.mark(reg.create());
+        reg.clear();
+        REQUIRE(changes.is_empty());
+    }
+}
+
+TEST_CASE("Change log") {
+    constexpr std::size_t round_count = 10000;
+    st::ecs_registry reg;
+    std::vector<st::entity> entities(16);
+    for(auto &en: entities) {
+        en = reg.create();
+    }
+    st::change_log log;
+    log.add_reader(0);
+    log.add_reader(1);
+    const auto keep_all = [](st::entity) { return true; };
+
+    SECTION("A reader that is never read does not grow the log forever") {
+        std::size_t largest{};
+        bool is_active_reader_complete{true};
+        for(std::size_t round = 0; round < round_count; ++round) {
+            for(auto en: entities) {
+                log.record(en);
+            }
+            largest = std::max(largest, log.size());
+            is_active_reader_complete = is_active_reader_complete && log.read(0, keep_all).size() == entities.size();
+        }
+        REQUIRE(is_active_reader_complete);
+        REQUIRE(largest < round_count * entities.size() / 10);
+        REQUIRE_THAT(log.read(1, keep_all), RangeEquals(entities));
+        REQUIRE(log.read(1, keep_all).empty());
+    }
+}
+
+TEST_CASE("Change tracker benchmark", "[.][benchmark]") {
+    constexpr int entity_count = 10000;
+    st::ecs_registry reg;
+    std::vector<st::entity> entities;
+    for(int i = 0; i < entity_count; ++i) {
+        entities.push_back(reg.create());
+    }
+
+    BENCHMARK("Tag component emplace and destroy_all") {
+        for(auto en: entities) {
+            reg.emplace_if_not_exist<tracked_tag>(en);
+        }
+        reg.destroy_all<tracked_tag>();
+        return reg.view<tracked_tag>().begin() == reg.view<tracked_tag>().end();
+    };
+
+    BENCHMARK("Tracker mark and clear") {
+        auto &changes = reg.tracker<tracked_tag>();
+        for(auto en: entities) {
+            changes.mark(en);
+        }
+        const auto size = changes.size();
+        changes.clear();
+        return size;
+    };
+}
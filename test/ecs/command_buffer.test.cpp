@@ -0,0 +1,153 @@
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+import stay3.core;
+import stay3.ecs;
+using st::mut;
+
+namespace {
+struct position {
+    int value;
+};
+struct label {
+    std::string name;
+};
+struct marker {};
+} // namespace
+
+TEST_CASE("Command buffer") {
+    st::ecs_registry reg;
+    st::ecs_command_buffer commands{reg};
+
+    SECTION("Nothing happens before playback") {
+        auto en = reg.create();
+        commands.emplace<position>(en, 1);
+        commands.destroy_if_exist(en);
+        REQUIRE_FALSE(reg.contains<position>(en));
+        REQUIRE(reg.contains(en));
+        commands.playback();
+        REQUIRE_FALSE(reg.contains(en));
+    }
+
+    SECTION("Deferred entities") {
+        const auto deferred = commands.create();
+        commands.emplace<position>(deferred, 5);
+        commands.emplace<label>(deferred, "deferred");
+        commands.emplace<marker>(deferred);
+        commands.playback();
+
+        const auto en = commands.resolve(deferred);
+        REQUIRE(reg.contains(en));
+        REQUIRE(reg.get<position>(en)->value == 5);
+        REQUIRE(reg.get<label>(en)->name == "deferred");
+        REQUIRE(reg.contains<marker>(en));
+    }
+
+    SECTION("Remove components while iterating") {
+        std::vector<st::entity> entities;
+        for(int i = 0; i < 10; ++i) {
+            entities.push_back(reg.create());
+            reg.emplace<position>(entities.back(), i);
+            reg.emplace<marker>(entities.back());
+        }
+        for(auto [en, pos]: reg.each<position>()) {
+            if(pos->value % 2 == 0) {
+                commands.destroy_if_exist<marker, position>(en);
+            }
+        }
+        commands.playback();
+        for(int i = 0; i < 10; ++i) {
+            REQUIRE(reg.contains<marker>(entities[i]) == (i % 2 != 0));
+            REQUIRE(reg.contains<position>(entities[i]) == (i % 2 != 0));
+        }
+    }
+
+    SECTION("Entities destroyed or already holding the component") {
+        auto destroyed = reg.create();
+        commands.emplace<position>(destroyed, 1);
+        commands.emplace<marker>(destroyed);
+        commands.destroy_if_exist<label>(destroyed);
+        reg.destroy(destroyed);
+
+        auto existing = reg.create();
+        reg.emplace<marker>(existing);
+        commands.emplace<position>(existing, 1);
+        commands.emplace<position>(existing, 2);
+        commands.emplace<marker>(existing);
+        REQUIRE_NOTHROW(commands.playback());
+        REQUIRE_FALSE(reg.contains(destroyed));
+        REQUIRE(reg.get<position>(existing)->value == 2);
+        REQUIRE(reg.contains<marker>(existing));
+    }
+
+    SECTION("Recorded order is kept per component") {
+        auto en = reg.create();
+        reg.emplace<position>(en, 1);
+        commands.destroy_if_exist<position>(en);
+        commands.emplace<position>(en, 2);
+        commands.emplace<marker>(en);
+        commands.destroy_if_exist<marker>(en);
+        commands.playback();
+        REQUIRE(reg.get<position>(en)->value == 2);
+        REQUIRE_FALSE(reg.contains<marker>(en));
+    }
+
+    SECTION("Construct events are published at playback") {
+        int constructed{};
+        reg.on<st::comp_event::construct, position>().connect<+[](int &count, st::ecs_registry &, st::entity) {
+            ++count;
+        }>(constructed);
+        commands.emplace<position>(commands.create(), 1);
+        commands.emplace<position>(commands.create(), 2);
+        REQUIRE(constructed == 0);
+        commands.playback();
+        REQUIRE(constructed == 2);
+    }
+
+    SECTION("Buffer can be reused") {
+        commands.emplace<position>(commands.create(), 1);
+        commands.playback();
+        commands.emplace<position>(commands.create(), 2);
+        commands.playback();
+        int count{};
+        for(auto en: reg.view<position>()) {
+            static_cast<void>(en);
+            ++count;
+        }
+        REQUIRE(count == 2);
+    }
+
+    SECTION("Recording from worker threads") {
+        constexpr std::size_t count = 4000;
+        std::vector<st::entity> entities;
+        for(std::size_t i = 0; i < count; ++i) {
+            entities.push_back(reg.create());
+            reg.emplace<position>(entities.back(), static_cast<int>(i));
+        }
+        st::thread_pool pool{4};
+        reg.par_each<position>(pool, [&](st::entity en, auto pos) {
+            if(pos->value % 2 == 0) {
+                commands.emplace<marker>(en);
+            } else {
+                commands.destroy_if_exist(en);
+            }
+            static_cast<void>(commands.create());
+        });
+        commands.playback();
+        for(std::size_t i = 0; i < count; ++i) {
+            if(i % 2 == 0) {
+                REQUIRE(reg.contains<marker>(entities[i]));
+            } else {
+                REQUIRE_FALSE(reg.contains(entities[i]));
+            }
+        }
+        std::size_t alive{};
+        for(auto en: reg.view<position>()) {
+            static_cast<void>(en);
+            ++alive;
+        }
+        REQUIRE(alive == count / 2);
+    }
+}
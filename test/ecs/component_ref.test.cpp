@@ -1,3 +1,6 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 #include <catch2/catch_all.hpp>
 
 import stay3.ecs;
@@ -68,3 +71,78 @@ TEST_CASE("comparison") {
     REQUIRE(ref1 == ref3);
     REQUIRE(ref1 != ref2);
 }
+
+TEST_CASE("Cached component address") {
+    ecs_registry registry{};
+    std::vector<entity> entities;
+    for(int i = 0; i < 4; ++i) {
+        entities.push_back(registry.create());
+        registry.emplace<test_component>(entities.back(), i);
+    }
+    component_ref<test_component> ref{entities.front()};
+    REQUIRE(ref.get(registry)->value == 0);
+
+    SECTION("Version changes when components move") {
+        const auto version = registry.storage_version<test_component>();
+        registry.emplace<test_component>(registry.create(), 10);
+        REQUIRE(registry.storage_version<test_component>() == version);
+        registry.destroy<test_component>(entities[1]);
+        REQUIRE(registry.storage_version<test_component>() != version);
+    }
+
+    SECTION("Removal of another component") {
+        // The last component is moved into the hole of the first one
+        component_ref<test_component> last{entities.back()};
+        REQUIRE(last.get(registry)->value == 3);
+        registry.destroy<test_component>(entities.front());
+        REQUIRE(last.get(registry)->value == 3);
+        last.get_mut(registry)->value = 30;
+        REQUIRE(registry.get<test_component>(entities.back())->value == 30);
+    }
+
+    SECTION("Sort") {
+        registry.sort<test_component>([](const test_component &lhs, const test_component &rhs) {
+            return lhs.value > rhs.value;
+        });
+        REQUIRE(ref.get(registry)->value == 0);
+    }
+
+    SECTION("Owned components are never cached") {
+        registry.emplace<float>(entities[2], 1.F);
+        static_cast<void>(registry.group<test_component>(get<float>));
+        REQUIRE(registry.storage_version<test_component>() == ecs_registry::unstable_storage);
+        REQUIRE(ref.get(registry)->value == 0);
+    }
+}
+
+TEST_CASE("Cached reference sort benchmark", "[.][benchmark]") {
+    struct material {
+        bool transparency;
+    };
+    struct rendered_mesh {
+        component_ref<material> mat;
+    };
+    constexpr int mesh_count = 10'000;
+    constexpr int material_count = 16;
+    ecs_registry registry{};
+    std::vector<entity> materials;
+    for(int i = 0; i < material_count; ++i) {
+        materials.push_back(registry.create());
+        registry.emplace<material>(materials.back(), i % 2 == 0);
+    }
+    for(int i = 0; i < mesh_count; ++i) {
+        registry.emplace<rendered_mesh>(registry.create(), materials[static_cast<std::size_t>(i) % materials.size()]);
+    }
+    std::uint32_t round{};
+    BENCHMARK("Sort 10k meshes by material") {
+        ++round;
+        registry.sort<rendered_mesh>([&registry, round](entity first, entity last) {
+            auto m1 = registry.get<rendered_mesh>(first)->mat.get(registry);
+            auto m2 = registry.get<rendered_mesh>(last)->mat.get(registry);
+            if(m1->transparency != m2->transparency) {
+                return !m1->transparency;
+            }
+            return (first.numeric() ^ round) < (last.numeric() ^ round);
+        });
+    };
+}
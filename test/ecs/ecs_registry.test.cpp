@@ -1,5 +1,7 @@
 #include <iterator>
+#include <string>
 #include <type_traits>
+#include <vector>
 #include <catch2/catch_all.hpp>
 
 import stay3.ecs;
@@ -185,8 +187,11 @@ TEST_CASE("Entity and Component Management") {
         SECTION("Clear component") {
             registry.emplace<dummy>(en, 30);
             registry.emplace<empty_dummy>(en);
+            REQUIRE_FALSE(registry.is_empty<dummy>());
             registry.destroy_all<dummy>();
             REQUIRE_FALSE(registry.contains<dummy>(en));
+            REQUIRE(registry.is_empty<dummy>());
+            REQUIRE_FALSE(registry.is_empty<empty_dummy>());
         }
     }
 }
@@ -268,6 +273,45 @@ TEST_CASE("Sort and iteration") {
             REQUIRE_THAT(ens, UnorderedRangeEquals({en1, en3}));
         }
 
+        SECTION("Group iteration") {
+            SECTION("Owning group") {
+                std::vector<st::entity> ens;
+                for(auto &&[entity, s, d]: registry.group<st::mut<second_comp>, dummy>()) {
+                    ens.emplace_back(entity);
+                    s->value += static_cast<float>(d->value);
+                }
+                REQUIRE_THAT(ens, UnorderedRangeEquals({en1, en3}));
+                REQUIRE(registry.get<second_comp>(en1)->value == 11.0f);
+                REQUIRE(registry.get<second_comp>(en3)->value == 33.0f);
+            }
+            SECTION("Partial owning group") {
+                auto group = registry.group<second_comp>(st::get<st::mut<dummy>>);
+                REQUIRE(group.size() == 2);
+                for(auto &&[entity, s, d]: group) {
+                    d->value = static_cast<int>(s->value);
+                }
+                REQUIRE(registry.get<dummy>(en1)->value == 1);
+                REQUIRE(registry.get<dummy>(en2)->value == 20);
+                auto [s3, d3] = group.get(en3);
+                REQUIRE(s3->value == 3.0f);
+                REQUIRE(d3->value == 3);
+            }
+            SECTION("Group with exclusion") {
+                std::vector<st::entity> ens;
+                for(auto &&[entity, d]: registry.group<dummy>(st::get<>, st::exclude<second_comp>)) {
+                    ens.emplace_back(entity);
+                }
+                REQUIRE_THAT(ens, UnorderedRangeEquals({en2}));
+            }
+            SECTION("Group is kept up to date") {
+                auto group = registry.group<second_comp, dummy>();
+                registry.emplace<second_comp>(en2, 2.0f);
+                REQUIRE(group.size() == 3);
+                registry.destroy<dummy>(en1);
+                REQUIRE(group.size() == 2);
+            }
+        }
+
         SECTION("Exclude iteration") {
             SECTION("Each") {
                 auto each = registry.each<st::mut<dummy>>(st::exclude<second_comp, int>);
@@ -350,4 +394,53 @@ TEST_CASE("Clear") {
         REQUIRE(entity_handler_called == 3);
         REQUIRE(component_handler_called == 2);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("View and group iteration benchmark", "[.][benchmark]") {
+    struct position {
+        float x, y, z;
+    };
+    struct velocity {
+        float x, y, z;
+    };
+    struct unrelated {
+        int value;
+    };
+    const auto populate = [](st::ecs_registry &reg, int count) {
+        for(int i = 0; i < count; ++i) {
+            auto en = reg.create();
+            // Interleave storages so that view iteration is not accidentally packed
+            if(i % 3 != 0) {
+                reg.emplace<unrelated>(en, i);
+            }
+            reg.emplace<velocity>(en, 1.F, 2.F, 3.F);
+            if(i % 2 == 0) {
+                reg.emplace<position>(en, 0.F, 0.F, 0.F);
+            }
+        }
+        for(int i = 0; i < count; i += 2) {
+            reg.emplace<position>(reg.create(), 0.F, 0.F, 0.F);
+        }
+    };
+    for(const int count: {10000, 100000}) {
+        st::ecs_registry view_registry;
+        populate(view_registry, count);
+        st::ecs_registry group_registry;
+        populate(group_registry, count);
+        auto group = group_registry.group<st::mut<position>, velocity>();
+
+        BENCHMARK("each with " + std::to_string(count) + " entities") {
+            for(auto &&[en, pos, vel]: view_registry.each<st::mut<position>, velocity>()) {
+                pos->x += vel->x;
+                pos->y += vel->y;
+                pos->z += vel->z;
+            }
+        };
+        BENCHMARK("group with " + std::to_string(count) + " entities") {
+            for(auto &&[en, pos, vel]: group) {
+                pos->x += vel->x;
+                pos->y += vel->y;
+                pos->z += vel->z;
+            }
+        };
+    }
+}
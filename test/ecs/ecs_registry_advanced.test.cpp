@@ -1,5 +1,12 @@
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
 #include <catch2/catch_all.hpp>
 
+import stay3.core;
 import stay3.ecs;
 using st::mut;
 
@@ -22,6 +29,13 @@ struct test_event_tracker {
     }
 };
 
+struct test_batch_tracker {
+    std::vector<std::vector<st::entity>> batches;
+    void on_batch(st::ecs_registry &, std::span<const st::entity> entities) {
+        batches.emplace_back(entities.begin(), entities.end());
+    }
+};
+
 struct complex_component {
     std::string name;
     int value;
@@ -156,6 +170,66 @@ TEST_CASE("Advanced Entity and Component Scenarios") {
             }
         }
 
+        SECTION("Batched Update Event") {
+            test_batch_tracker batch_tracker;
+            registry.emplace<dummy>(en);
+            auto en2 = registry.create();
+            registry.emplace<dummy>(en2);
+            registry.on<st::comp_event::update, dummy>()
+                .connect<&test_event_tracker::on_update>(tracker);
+            registry.on_batch<st::comp_event::update, dummy>()
+                .connect<&test_batch_tracker::on_batch>(batch_tracker);
+
+            SECTION("Outside of batch scope") {
+                registry.get<mut<dummy>>(en)->value = 1;
+                REQUIRE(tracker.update_count == 1);
+                REQUIRE(batch_tracker.batches.size() == 1);
+                REQUIRE(batch_tracker.batches[0] == std::vector{en});
+            }
+
+            SECTION("Inside batch scope") {
+                {
+                    const auto batch = registry.batch<st::comp_event::update, dummy>();
+                    for(auto [e, d]: registry.each<mut<dummy>>()) {
+                        d->value += 1;
+                    }
+                    registry.get<mut<dummy>>(en)->value += 1;
+                    REQUIRE(tracker.update_count == 0);
+                    REQUIRE(batch_tracker.batches.empty());
+                }
+                REQUIRE(tracker.update_count == 2);
+                REQUIRE(batch_tracker.batches.size() == 1);
+                REQUIRE_THAT(batch_tracker.batches[0], Catch::Matchers::UnorderedRangeEquals(std::vector{en, en2}));
+                REQUIRE(registry.get<dummy>(en)->value == 2);
+            }
+
+            SECTION("Nested batch scopes") {
+                {
+                    const auto outer = registry.batch<st::comp_event::update, dummy>();
+                    {
+                        const auto inner = registry.batch<st::comp_event::update, dummy>();
+                        registry.get<mut<dummy>>(en)->value = 1;
+                    }
+                    REQUIRE(batch_tracker.batches.empty());
+                    registry.get<mut<dummy>>(en2)->value = 1;
+                }
+                REQUIRE(batch_tracker.batches.size() == 1);
+                REQUIRE(batch_tracker.batches[0].size() == 2);
+            }
+
+            SECTION("Entities losing the component are skipped") {
+                {
+                    const auto batch = registry.batch<st::comp_event::update, dummy>();
+                    registry.get<mut<dummy>>(en)->value = 1;
+                    registry.get<mut<dummy>>(en2)->value = 1;
+                    registry.destroy(en2);
+                }
+                REQUIRE(tracker.update_count == 1);
+                REQUIRE(batch_tracker.batches.size() == 1);
+                REQUIRE(batch_tracker.batches[0] == std::vector{en});
+            }
+        }
+
         SECTION("Destroy Event") {
             registry.emplace<dummy>(en);
 
@@ -189,4 +263,214 @@ TEST_CASE("Advanced Entity and Component Scenarios") {
             REQUIRE(rc->value == 200);
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Parallel iteration") {
+    constexpr int entity_count = 5000;
+    st::ecs_registry registry;
+    st::thread_pool pool{4};
+    std::vector<st::entity> entities;
+    for(int i = 0; i < entity_count; ++i) {
+        auto en = registry.create();
+        registry.emplace<dummy>(en, i);
+        if(i % 2 == 0) {
+            registry.emplace<complex_component>(en, "even", 0);
+        }
+        entities.push_back(en);
+    }
+    test_event_tracker tracker;
+    test_batch_tracker batch_tracker;
+    registry.on<st::comp_event::update, dummy>().connect<&test_event_tracker::on_update>(tracker);
+    registry.on_batch<st::comp_event::update, dummy>().connect<&test_batch_tracker::on_batch>(batch_tracker);
+
+    SECTION("Every entity is visited once and events are merged") {
+        std::atomic<int> visits{};
+        std::atomic<int> early_events{};
+        registry.par_each<mut<dummy>>(pool, [&](st::entity, auto d) {
+            d->value *= 2;
+            visits.fetch_add(1, std::memory_order_relaxed);
+            early_events.fetch_add(tracker.update_count, std::memory_order_relaxed);
+        });
+        REQUIRE(visits.load() == entity_count);
+        REQUIRE(early_events.load() == 0);
+        REQUIRE(tracker.update_count == entity_count);
+        REQUIRE(batch_tracker.batches.size() == 1);
+        REQUIRE_THAT(batch_tracker.batches[0], Catch::Matchers::UnorderedRangeEquals(entities));
+        for(int i = 0; i < entity_count; ++i) {
+            REQUIRE(registry.get<dummy>(entities[i])->value == i * 2);
+        }
+    }
+
+    SECTION("Read only access does not publish events") {
+        std::atomic<long long> sum{};
+        std::atomic<int> mismatches{};
+        registry.par_each<dummy, complex_component>(pool, [&](st::entity, auto d, auto c) {
+            if(c->name != "even") {
+                mismatches.fetch_add(1, std::memory_order_relaxed);
+            }
+            sum.fetch_add(d->value, std::memory_order_relaxed);
+        });
+        REQUIRE(mismatches.load() == 0);
+        long long expected{};
+        for(int i = 0; i < entity_count; i += 2) {
+            expected += i;
+        }
+        REQUIRE(sum.load() == expected);
+        REQUIRE(tracker.update_count == 0);
+        REQUIRE(batch_tracker.batches.empty());
+    }
+
+    SECTION("Excluded components") {
+        std::atomic<int> visits{};
+        const auto reset = [&](st::entity, auto d) {
+            d->value = -1;
+            visits.fetch_add(1, std::memory_order_relaxed);
+        };
+        registry.par_each<mut<dummy>>(pool, reset, st::exclude<complex_component>);
+        REQUIRE(visits.load() == entity_count / 2);
+        REQUIRE(tracker.update_count == entity_count / 2);
+        REQUIRE(registry.get<dummy>(entities[0])->value == 0);
+        REQUIRE(registry.get<dummy>(entities[1])->value == -1);
+    }
+
+    SECTION("Given entities") {
+        const std::span<const st::entity> some{entities.data(), 100};
+        registry.par_each<mut<dummy>>(pool, some, [](st::entity, auto d) {
+            d->value = -1;
+        });
+        REQUIRE(tracker.update_count == 100);
+        REQUIRE(registry.get<dummy>(entities[99])->value == -1);
+        REQUIRE(registry.get<dummy>(entities[100])->value == 100);
+    }
+}
+
+TEST_CASE("Parallel iteration benchmark", "[.][benchmark]") {
+    constexpr int entity_count = 100000;
+    st::ecs_registry registry;
+    for(int i = 0; i < entity_count; ++i) {
+        auto en = registry.create();
+        registry.emplace<dummy>(en, i);
+        registry.emplace<complex_component>(en, "bench", i);
+    }
+    const auto work = [](st::entity, auto d, auto c) {
+        for(int i = 0; i < 64; ++i) {
+            d->value = (d->value * 31 + c->value) % 1000003;
+        }
+    };
+
+    BENCHMARK("each") {
+        for(auto [en, d, c]: registry.each<mut<dummy>, complex_component>()) {
+            work(en, std::move(d), c);
+        }
+    };
+    for(const std::size_t thread_count: {1, 2, 4, 8}) {
+        st::thread_pool pool{thread_count};
+        BENCHMARK("par_each with " + std::to_string(thread_count) + " threads") {
+            registry.par_each<mut<dummy>, complex_component>(pool, work);
+        };
+    }
+}
+
+TEST_CASE("Component event dispatch benchmark", "[.][benchmark]") {
+    constexpr int component_count = 1000000;
+    test_event_tracker tracker;
+
+    BENCHMARK("Emplace with listeners") {
+        st::ecs_registry registry;
+        registry.on<st::comp_event::construct, dummy>().connect<&test_event_tracker::on_construct>(tracker);
+        for(int i = 0; i < component_count; ++i) {
+            registry.emplace<dummy>(registry.create(), i);
+        }
+        return tracker.construct_count;
+    };
+
+    st::ecs_registry registry;
+    registry.on<st::comp_event::update, dummy>().connect<&test_event_tracker::on_update>(tracker);
+    for(int i = 0; i < component_count; ++i) {
+        registry.emplace<dummy>(registry.create(), i);
+    }
+    BENCHMARK("Update with listeners") {
+        for(auto [en, d]: registry.each<mut<dummy>>()) {
+            ++d->value;
+        }
+        return tracker.update_count;
+    };
+}
+
+TEST_CASE("Reactive filters") {
+    struct first_reader {};
+    struct second_reader {};
+    st::ecs_registry registry;
+    registry.watch<st::changed<dummy>, first_reader>();
+    registry.watch<st::added<dummy>, first_reader>();
+    registry.watch<st::removed<dummy>, first_reader>();
+
+    const auto en1 = registry.create();
+    const auto en2 = registry.create();
+    registry.emplace<dummy>(en1, 1);
+    registry.emplace<dummy>(en2, 2);
+    const auto as_vector = [](std::span<const st::entity> entities) {
+        return std::vector<st::entity>{entities.begin(), entities.end()};
+    };
+
+    SECTION("Each entity is listed once") {
+        registry.get<mut<dummy>>(en1)->value = 10;
+        registry.get<mut<dummy>>(en1)->value = 11;
+        const auto changed = as_vector(registry.each<st::changed<dummy>, first_reader>());
+        REQUIRE(changed.size() == 2);
+        REQUIRE(changed[0] == en1);
+        REQUIRE(changed[1] == en2);
+        REQUIRE(registry.each<st::changed<dummy>, first_reader>().empty());
+    }
+
+    SECTION("Added, changed and removed are separate") {
+        static_cast<void>(registry.each<st::added<dummy>, first_reader>());
+        static_cast<void>(registry.each<st::changed<dummy>, first_reader>());
+        registry.get<mut<dummy>>(en2)->value = 20;
+        registry.destroy<dummy>(en1);
+        REQUIRE(registry.each<st::added<dummy>, first_reader>().empty());
+        REQUIRE(as_vector(registry.each<st::changed<dummy>, first_reader>()) == std::vector{en2});
+        const auto removed = as_vector(registry.each<st::removed<dummy>, first_reader>());
+        REQUIRE(removed == std::vector{en1});
+    }
+
+    SECTION("Entities that lost the component are skipped") {
+        registry.destroy(en2);
+        REQUIRE(as_vector(registry.each<st::added<dummy>, first_reader>()) == std::vector{en1});
+    }
+
+    SECTION("Readers have their own cursor") {
+        registry.watch<st::changed<dummy>, second_reader>();
+        REQUIRE(registry.each<st::changed<dummy>, first_reader>().size() == 2);
+        registry.get<mut<dummy>>(en2)->value = 3;
+        REQUIRE(registry.each<st::changed<dummy>, second_reader>().size() == 2);
+        REQUIRE(registry.each<st::changed<dummy>, first_reader>().size() == 1);
+    }
+
+    SECTION("Events without readers are not recorded") {
+        registry.emplace<complex_component>(en1, "name", 1);
+        REQUIRE(registry.each<st::added<complex_component>>().empty());
+    }
+}
+
+TEST_CASE("Reactive filter benchmark", "[.][benchmark]") {
+    constexpr int entity_count = 100000;
+    struct reader {};
+    st::ecs_registry registry;
+    registry.watch<st::changed<dummy>, reader>();
+    std::vector<st::entity> entities;
+    for(int i = 0; i < entity_count; ++i) {
+        entities.push_back(registry.create());
+        registry.emplace<dummy>(entities.back(), i);
+    }
+    static_cast<void>(registry.each<st::changed<dummy>, reader>());
+
+    BENCHMARK("Nothing changed") {
+        return registry.each<st::changed<dummy>, reader>().size();
+    };
+    BENCHMARK("1% changed") {
+        for(std::size_t i = 0; i < entities.size(); i += 100) {
+            ++registry.get<mut<dummy>>(entities[i])->value;
+        }
+        return registry.each<st::changed<dummy>, reader>().size();
+    };
+}
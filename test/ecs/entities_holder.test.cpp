@@ -1,5 +1,6 @@
 #include <iterator>
 #include <ranges>
+#include <span>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -22,6 +23,11 @@ struct fixture {
             holder.on_create().connect<[](holder_wrapper &this_wrapper, entity en) {
                 this_wrapper.fi->entity_to_holder.emplace(en, &this_wrapper);
             }>(*this);
+            holder.on_create_batch().connect<[](holder_wrapper &this_wrapper, std::span<const entity> entities) {
+                for(auto en: entities) {
+                    this_wrapper.fi->entity_to_holder.emplace(en, &this_wrapper);
+                }
+            }>(*this);
         }
     };
     ecs_registry reg;
@@ -194,3 +200,81 @@ TEST_CASE("Iteration") {
         REQUIRE(iterated == entities);
     }
 }
+
+TEST_CASE("Slot bookkeeping") {
+    fixture fi;
+    entities_holder es{fi.reg};
+    fi.init_holder(es);
+    const auto first = es.create();
+    const auto second = es.create();
+    const auto third = es.create();
+    const auto fourth = es.create();
+
+    SECTION("Removal keeps the first entity in place") {
+        es.destroy(second);
+        REQUIRE(es.size() == 3);
+        REQUIRE(es[0] == first);
+        REQUIRE(es[1] == fourth);
+        REQUIRE_FALSE(es.contains(second));
+        es.destroy(fourth);
+        es.destroy(third);
+        REQUIRE(es[0] == first);
+        REQUIRE(es.contains(first));
+        es.destroy(first);
+        REQUIRE(es.is_empty());
+    }
+
+    SECTION("Destroy by index after removals") {
+        fi.reg.destroy(third);
+        REQUIRE(es.size() == 3);
+        REQUIRE(es[2] == fourth);
+        es.destroy(2);
+        REQUIRE_FALSE(fi.reg.contains(fourth));
+        REQUIRE(es.contains(second));
+    }
+}
+
+TEST_CASE("Bulk creation and destruction") {
+    fixture fi;
+    entities_holder es{fi.reg};
+    fi.init_holder(es);
+    struct batch_listener {
+        std::vector<entity> entities;
+        int calls{};
+        void on_batch(std::span<const entity> batch) {
+            entities.assign(batch.begin(), batch.end());
+            ++calls;
+        }
+    };
+    batch_listener created;
+    batch_listener destroyed;
+    listener single;
+    es.on_create_batch().connect<&batch_listener::on_batch>(created);
+    es.on_destroy_batch().connect<&batch_listener::on_batch>(destroyed);
+    es.on_create().connect<&listener::on_other_entity_update>(single);
+    es.on_destroy().connect<&listener::on_other_entity_update>(single);
+
+    const auto leader = es.create();
+    constexpr std::size_t count = 1000;
+    const auto batch = es.create_n(count);
+    REQUIRE(batch.size() == count);
+    REQUIRE(es.size() == count + 1);
+    REQUIRE(es[0] == leader);
+    REQUIRE(created.calls == 1);
+    REQUIRE(created.entities.size() == count);
+    REQUIRE(single.en == leader);
+    for(auto en: created.entities) {
+        REQUIRE(fi.reg.contains(en));
+        REQUIRE(es.contains(en));
+    }
+
+    es.destroy_all();
+    REQUIRE(es.is_empty());
+    REQUIRE(destroyed.calls == 1);
+    REQUIRE(destroyed.entities.size() == count + 1);
+    REQUIRE(destroyed.entities.front() == leader);
+    REQUIRE(single.en == leader);
+    for(auto en: destroyed.entities) {
+        REQUIRE_FALSE(fi.reg.contains(en));
+    }
+}
@@ -0,0 +1,130 @@
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+import stay3.ecs;
+
+using namespace st;
+
+namespace {
+struct position {
+    float x;
+    float y;
+};
+struct label {
+    std::string name;
+};
+struct dependent {};
+
+struct batch_counter {
+    std::vector<std::size_t> sizes;
+    void on_batch(ecs_registry &, std::span<const entity> entities) {
+        sizes.push_back(entities.size());
+    }
+};
+} // namespace
+
+TEST_CASE("Prefab instantiation") {
+    ecs_registry reg;
+    prefab blueprint{position{.x = 1.F, .y = 2.F}, label{.name = "platform"}};
+    constexpr std::size_t count = 5;
+    std::vector<entity> entities;
+    for(std::size_t i = 0; i < count; ++i) {
+        entities.push_back(reg.create());
+    }
+
+    SECTION("Every entity gets a copy") {
+        blueprint.instantiate(reg, entities);
+        for(const auto en: entities) {
+            REQUIRE(reg.get<position>(en)->x == 1.F);
+            REQUIRE(reg.get<position>(en)->y == 2.F);
+            REQUIRE(reg.get<label>(en)->name == "platform");
+        }
+        reg.get<mut<label>>(entities[0])->name = "changed";
+        REQUIRE(reg.get<label>(entities[1])->name == "platform");
+        REQUIRE(blueprint.get<label>().name == "platform");
+    }
+
+    SECTION("Values can be changed before instantiation") {
+        blueprint.get<position>().x = 3.F;
+        blueprint.instantiate(reg, entities);
+        REQUIRE(reg.get<position>(entities.back())->x == 3.F);
+    }
+
+    SECTION("One construct batch per component type") {
+        batch_counter positions;
+        batch_counter labels;
+        reg.on_batch<comp_event::construct, position>().connect<&batch_counter::on_batch>(positions);
+        reg.on_batch<comp_event::construct, label>().connect<&batch_counter::on_batch>(labels);
+        blueprint.instantiate(reg, entities);
+        REQUIRE(positions.sizes == std::vector{count});
+        REQUIRE(labels.sizes == std::vector{count});
+    }
+
+    SECTION("Listeners see whole instances") {
+        struct listener {
+            std::size_t complete{};
+            void on_construct(ecs_registry &registry, entity en) {
+                if(registry.contains<label>(en)) {
+                    ++complete;
+                }
+            }
+        } position_listener;
+        reg.on<comp_event::construct, position>().connect<&listener::on_construct>(position_listener);
+        blueprint.instantiate(reg, entities);
+        REQUIRE(position_listener.complete == count);
+    }
+
+    SECTION("Dependencies are applied") {
+        make_hard_dependency<dependent, position>(reg);
+        blueprint.instantiate(reg, entities);
+        for(const auto en: entities) {
+            REQUIRE(reg.contains<dependent>(en));
+        }
+    }
+}
+
+TEST_CASE("Bulk insert") {
+    ecs_registry reg;
+    std::vector<entity> entities{reg.create(), reg.create(), reg.create()};
+    batch_counter counter;
+    reg.on_batch<comp_event::construct, position>().connect<&batch_counter::on_batch>(counter);
+
+    reg.insert<position>(entities, {.x = 4.F, .y = 0.F});
+    for(const auto en: entities) {
+        REQUIRE(reg.get<position>(en)->x == 4.F);
+    }
+    REQUIRE(counter.sizes == std::vector<std::size_t>{entities.size()});
+}
+
+TEST_CASE("Prefab instantiation benchmark", "[.][benchmark]") {
+    constexpr std::size_t count = 10'000;
+    const prefab blueprint{position{}, label{.name = "platform"}};
+    const auto create_entities = [](ecs_registry &reg) {
+        std::vector<entity> entities;
+        entities.reserve(count);
+        for(std::size_t i = 0; i < count; ++i) {
+            entities.push_back(reg.create());
+        }
+        make_hard_dependency<dependent, position>(reg);
+        return entities;
+    };
+
+    BENCHMARK("Instantiate 10k entities") {
+        ecs_registry reg;
+        const auto entities = create_entities(reg);
+        blueprint.instantiate(reg, entities);
+        return reg.get<label>(entities.back())->name.size();
+    };
+    BENCHMARK("Emplace 10k entities") {
+        ecs_registry reg;
+        const auto entities = create_entities(reg);
+        for(const auto en: entities) {
+            reg.emplace<position>(en);
+            reg.emplace<label>(en, "platform");
+        }
+        return reg.get<label>(entities.back())->name.size();
+    };
+}
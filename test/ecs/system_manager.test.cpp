@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 #include <catch2/catch_all.hpp>
 
 import stay3.core;
@@ -204,4 +211,267 @@ TEST_CASE("System run result is used") {
 
     REQUIRE(ctx.render_count == 2);
     REQUIRE_THAT(ctx.messages, RangeEquals({"render software", "exit"}));
-}
\ No newline at end of file
+}
+TEST_CASE("Move-only and large systems") {
+    struct move_only_system {
+        move_only_system(int value)
+            : value{std::make_unique<int>(value)} {}
+        move_only_system(const move_only_system &) = delete;
+        move_only_system(move_only_system &&) noexcept = delete;
+        move_only_system &operator=(const move_only_system &) = delete;
+        move_only_system &operator=(move_only_system &&) noexcept = delete;
+        ~move_only_system() = default;
+        void update(seconds, test_context &ctx) const {
+            ctx.update_count += *value;
+        }
+        std::unique_ptr<int> value;
+    };
+    struct large_system {
+        std::array<int, 64> values{};
+        void render(test_context &ctx) {
+            values.back() += 1;
+            ctx.render_count = values.back();
+        }
+    };
+    test_context ctx;
+    system_manager<test_context> manager;
+    manager.add<move_only_system>(3).run_as<sys_type::update>();
+    manager.add<large_system>().run_as<sys_type::render>();
+    manager.update(seconds{1.F}, ctx);
+    manager.render(ctx);
+    manager.render(ctx);
+    REQUIRE(ctx.update_count == 3);
+    REQUIRE(ctx.render_count == 2);
+}
+
+TEST_CASE("System dispatch benchmark", "[.][benchmark]") {
+    struct counting_system {
+        void update(seconds, test_context &ctx) {
+            ++count;
+            ctx.update_count = count;
+        }
+        int count{};
+    };
+    test_context ctx;
+    system_manager<test_context> manager;
+    for(int i = 0; i < 100; ++i) {
+        manager.add<counting_system>().run_as<sys_type::update>();
+    }
+    BENCHMARK("Dispatch 100 update systems") {
+        return manager.update(seconds{1.F}, ctx);
+    };
+}
+
+namespace {
+template<int index>
+struct slot {
+    float value;
+};
+
+struct schedule_context {
+    std::vector<std::string> messages;
+};
+
+template<int index>
+struct independent_system {
+    using access = sys_access<mut<slot<index>>>;
+    static constexpr bool is_concurrent = true;
+    void update(seconds, schedule_context &) {
+        ++run_count;
+    }
+    int run_count{};
+};
+
+struct slot_writer {
+    using access = sys_access<mut<slot<0>>>;
+    static void update(seconds, schedule_context &ctx) {
+        ctx.messages.emplace_back("write");
+    }
+};
+
+struct slot_reader {
+    using access = sys_access<slot<0>, slot<1>>;
+    static void update(seconds, schedule_context &ctx) {
+        ctx.messages.emplace_back("read");
+    }
+};
+
+template<int index>
+struct slot_logger {
+    using access = sys_access<mut<slot<index>>>;
+    static void update(seconds, schedule_context &ctx) {
+        ctx.messages.emplace_back(std::to_string(index));
+    }
+};
+
+struct undeclared_system {
+    static void update(seconds, schedule_context &ctx) {
+        ctx.messages.emplace_back("undeclared");
+    }
+};
+
+std::size_t wave_count(const std::string &dump) {
+    return static_cast<std::size_t>(std::ranges::count(dump, '\n'));
+}
+} // namespace
+
+TEST_CASE("Systems are scheduled by declared access") {
+    thread_pool pool{4};
+    system_manager<schedule_context> manager{pool};
+    schedule_context ctx;
+
+    SECTION("Independent systems share a wave") {
+        manager.add<independent_system<0>>().run_as<sys_type::update>(sys_priority::high);
+        manager.add<independent_system<1>>().run_as<sys_type::update>(sys_priority::low);
+        manager.add<independent_system<2>>().run_as<sys_type::update>();
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 1);
+        REQUIRE(manager.update(seconds{1.F}, ctx) == sys_run_result::noop);
+    }
+
+    SECTION("Conflicting systems keep priority order") {
+        manager.add<slot_reader>().run_as<sys_type::update>(sys_priority::high);
+        manager.add<slot_writer>().run_as<sys_type::update>(sys_priority::low);
+        manager.add<independent_system<2>>().run_as<sys_type::update>(sys_priority::very_low);
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 2);
+        manager.update(seconds{1.F}, ctx);
+        REQUIRE_THAT(ctx.messages, RangeEquals({"read", "write"}));
+    }
+
+    SECTION("Waves with systems not opting in to concurrency run in priority order") {
+        manager.add<slot_logger<1>>().run_as<sys_type::update>(sys_priority::low);
+        manager.add<slot_logger<0>>().run_as<sys_type::update>(sys_priority::high);
+        manager.add<slot_logger<2>>().run_as<sys_type::update>(sys_priority::very_low);
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 1);
+        manager.update(seconds{1.F}, ctx);
+        REQUIRE_THAT(ctx.messages, RangeEquals({"0", "1", "2"}));
+    }
+
+    SECTION("Systems without declared access run alone") {
+        manager.add<independent_system<0>>().run_as<sys_type::update>(sys_priority::high);
+        manager.add<undeclared_system>().run_as<sys_type::update>();
+        manager.add<independent_system<1>>().run_as<sys_type::update>(sys_priority::low);
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 3);
+    }
+
+    SECTION("Access declared through proxy") {
+        manager.add<undeclared_system>().run_as<sys_type::update>().access<slot<5>>();
+        manager.add<independent_system<0>>().run_as<sys_type::update>();
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 1);
+        manager.add<slot_writer>().run_as<sys_type::update>().access<mut<slot<5>>>();
+        REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 2);
+    }
+}
+
+namespace {
+struct registry_context {
+    ecs_registry reg;
+    ecs_registry &ecs() {
+        return reg;
+    }
+};
+
+template<int index>
+struct slot_incrementer {
+    using access = sys_access<mut<slot<index>>>;
+    static constexpr bool is_concurrent = true;
+    static void update(seconds, registry_context &ctx) {
+        for(auto &&[en, value]: ctx.ecs().each<mut<slot<index>>>()) {
+            value->value += 1.F;
+        }
+    }
+};
+} // namespace
+
+TEST_CASE("Concurrent systems with a registry") {
+    thread_pool pool{4};
+    system_manager<registry_context> manager{pool};
+    registry_context ctx;
+    auto &reg = ctx.ecs();
+    constexpr std::size_t entity_count = 64;
+    for(std::size_t i = 0; i < entity_count; ++i) {
+        const auto en = reg.create();
+        reg.emplace<slot<0>>(en, 0.F);
+        reg.emplace<slot<1>>(en, 0.F);
+    }
+    manager.add<slot_incrementer<0>>().run_as<sys_type::update>();
+    manager.add<slot_incrementer<1>>().run_as<sys_type::update>();
+    // Its storage does not exist until the wave prepares it
+    manager.add<slot_incrementer<2>>().run_as<sys_type::update>();
+    REQUIRE(wave_count(manager.dump_schedule(sys_type::update)) == 1);
+
+    const auto check_values = [&reg](float expected) {
+        for(auto &&[en, first, second]: reg.each<slot<0>, slot<1>>()) {
+            REQUIRE(first->value == expected);
+            REQUIRE(second->value == expected);
+        }
+    };
+
+    SECTION("Unobserved writes") {
+        manager.update(seconds{1.F}, ctx);
+        manager.update(seconds{1.F}, ctx);
+        check_values(2.F);
+        REQUIRE(reg.is_empty<slot<2>>());
+    }
+
+    SECTION("Observed writes keep listeners on the calling thread") {
+        struct listener {
+            std::thread::id caller{std::this_thread::get_id()};
+            std::size_t calls{};
+            bool is_on_caller{true};
+            void on_update(ecs_registry &, entity) {
+                ++calls;
+                is_on_caller = is_on_caller && std::this_thread::get_id() == caller;
+            }
+        } lis;
+        reg.on<comp_event::update, slot<0>>().connect<&listener::on_update>(lis);
+        manager.update(seconds{1.F}, ctx);
+        check_values(1.F);
+        REQUIRE(lis.calls == entity_count);
+        REQUIRE(lis.is_on_caller);
+    }
+}
+
+namespace {
+template<int index>
+struct busy_system {
+    using access = sys_access<mut<slot<index>>>;
+    static constexpr bool is_concurrent = true;
+    busy_system()
+        : data(50000, 1.F) {}
+    void update(seconds, schedule_context &) {
+        for(auto &value: data) {
+            value = (value * 1.0001F) + 0.5F;
+        }
+    }
+    std::vector<float> data;
+};
+
+template<int... indices>
+void add_busy_systems(system_manager<schedule_context> &manager, bool declare_access, std::integer_sequence<int, indices...>) {
+    const auto add_one = [&]<int index>() {
+        auto proxy = manager.add<busy_system<index>>();
+        proxy.template run_as<sys_type::update>();
+        if(!declare_access) {
+            // Overlapping access forces serial execution
+            proxy.template access<mut<slot<0>>>();
+        }
+    };
+    (add_one.template operator()<indices>(), ...);
+}
+} // namespace
+
+TEST_CASE("Parallel system scheduling benchmark", "[.][benchmark]") {
+    constexpr auto system_count = std::make_integer_sequence<int, 12>{};
+    schedule_context ctx;
+    system_manager<schedule_context> serial;
+    add_busy_systems(serial, false, system_count);
+    system_manager<schedule_context> parallel;
+    add_busy_systems(parallel, true, system_count);
+
+    BENCHMARK("12 update systems, serial") {
+        return serial.update(seconds{1.F}, ctx);
+    };
+    BENCHMARK("12 update systems, parallel") {
+        return parallel.update(seconds{1.F}, ctx);
+    };
+}
@@ -0,0 +1,87 @@
+#include <sstream>
+#include <string>
+#include <catch2/catch_all.hpp>
+
+import stay3.core;
+import stay3.ecs;
+
+using namespace st;
+
+TEST_CASE("Profiler statistics") {
+    system_profiler profiler;
+    const auto update_zone = profiler.add_zone("physics", sys_type::update);
+    const auto render_zone = profiler.add_zone("renderer", sys_type::render);
+    static_cast<void>(render_zone);
+
+    SECTION("Zones without samples are skipped") {
+        REQUIRE(profiler.stats().empty());
+    }
+
+    SECTION("Min, average and 99th percentile") {
+        for(ticks duration = 1; duration <= 100; ++duration) {
+            profiler.record(update_zone, 0, duration);
+        }
+        const auto stats = profiler.stats();
+        REQUIRE(stats.size() == 1);
+        REQUIRE(stats[0].system == "physics");
+        REQUIRE(stats[0].phase == sys_type::update);
+        REQUIRE(stats[0].samples == 100);
+        REQUIRE(stats[0].min == 1);
+        REQUIRE(stats[0].avg == 50);
+        REQUIRE(stats[0].p99 == 99);
+    }
+
+    SECTION("Only the latest samples are kept") {
+        for(std::size_t i = 0; i < system_profiler::window_size; ++i) {
+            profiler.record(update_zone, 0, 1000);
+        }
+        for(std::size_t i = 0; i < system_profiler::window_size; ++i) {
+            profiler.record(update_zone, 0, 10);
+        }
+        const auto stats = profiler.stats();
+        REQUIRE(stats[0].samples == system_profiler::window_size);
+        REQUIRE(stats[0].p99 == 10);
+    }
+}
+
+TEST_CASE("Profiler Chrome trace") {
+    system_profiler profiler;
+    const auto zone = profiler.add_zone("physics", sys_type::update);
+    profiler.capture_trace(2, 3);
+    for(int frame = 1; frame <= 4; ++frame) {
+        profiler.next_frame();
+        profiler.record(zone, 1000 * frame, 500);
+    }
+    std::ostringstream out;
+    profiler.write_chrome_trace(out);
+    const auto json = out.str();
+
+    REQUIRE(json.starts_with(R"({"traceEvents":[)"));
+    REQUIRE(json.ends_with("]}"));
+    REQUIRE(json.find(R"("name":"physics","cat":"update","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"("ts":2.000,"dur":0.500)") != std::string::npos);
+    REQUIRE(json.find(R"("ts":3.000)") != std::string::npos);
+    REQUIRE(json.find(R"("ts":1.000)") == std::string::npos);
+    REQUIRE(json.find(R"("ts":4.000)") == std::string::npos);
+}
+
+TEST_CASE("System manager records its systems") {
+    struct context {};
+    struct some_system {
+        static void update(seconds, context &) {}
+    };
+    system_manager<context> manager;
+    manager.add<some_system>().run_as<sys_type::update>();
+    context ctx;
+    manager.update(seconds{1.F}, ctx);
+    manager.update(seconds{1.F}, ctx);
+
+    const auto stats = manager.profiler().stats();
+    if constexpr(profiler_enabled) {
+        REQUIRE(stats.size() == 1);
+        REQUIRE(stats[0].samples == 2);
+        REQUIRE(stats[0].phase == sys_type::update);
+    } else {
+        REQUIRE(stats.empty());
+    }
+}
@@ -1,7 +1,10 @@
+#include <cstddef>
+#include <vector>
 #include <utility>
 #include <catch2/catch_all.hpp>
 
 import stay3.node;
+import stay3.ecs;
 using Catch::Matchers::UnorderedRangeEquals;
 
 struct reparented_handler {
@@ -174,3 +177,179 @@ TEST_CASE("Destruction is safe and can be called multiple times") {
     REQUIRE_NOTHROW(ctx.destroy_tree());
     REQUIRE_NOTHROW(ctx.destroy_tree());
 }
+
+TEST_CASE("Flattened hierarchy") {
+    st::tree_context ctx;
+    auto &root = ctx.root();
+    auto &a = root.add_child();
+    auto &b = root.add_child();
+    auto &a1 = a.add_child();
+    auto &a2 = a.add_child();
+    auto &b1 = b.add_child();
+
+    const auto ids = [&ctx]() {
+        std::vector<st::node::id_type> result;
+        for(const auto &entry: ctx.hierarchy()) {
+            result.push_back(entry.handle->id());
+        }
+        return result;
+    };
+    const auto size_of = [](const st::node &cur) {
+        return cur.subtree().front().subtree_size;
+    };
+
+    SECTION("Pre-order with subtree sizes") {
+        REQUIRE(ids() == std::vector{root.id(), a.id(), a1.id(), a2.id(), b.id(), b1.id()});
+        REQUIRE(size_of(root) == 6);
+        REQUIRE(size_of(a) == 3);
+        REQUIRE(size_of(b1) == 1);
+        const auto entries = ctx.hierarchy();
+        REQUIRE(entries[0].parent == st::node::flat_entry::no_parent);
+        REQUIRE(entries[2].parent == 1);
+        REQUIRE(entries[5].parent == 4);
+    }
+
+    SECTION("Nodes added out of place keep their entities and depth") {
+        auto &a3 = a.add_child();
+        const auto en = a3.entities().create();
+        auto &a31 = a3.add_child();
+        REQUIRE(a31.depth() == 3);
+        REQUIRE(ids() == std::vector{root.id(), a.id(), a1.id(), a2.id(), a3.id(), a31.id(), b.id(), b1.id()});
+        REQUIRE(size_of(a) == 5);
+        REQUIRE(a3.subtree().front().first_entity == en);
+        REQUIRE(&ctx.get_node(en) == &a3);
+        REQUIRE(ctx.hierarchy()[5].parent == 4);
+        REQUIRE(ctx.hierarchy()[7].parent == 6);
+    }
+
+    SECTION("Reparent forward") {
+        a.reparent(b1);
+        REQUIRE(ids() == std::vector{root.id(), b.id(), b1.id(), a.id(), a1.id(), a2.id()});
+        REQUIRE(size_of(b) == 5);
+        REQUIRE(size_of(b1) == 4);
+        REQUIRE(&a2.parent() == &a);
+        REQUIRE(ctx.hierarchy()[4].parent == 3);
+    }
+
+    SECTION("Reparent backward") {
+        b.reparent(a1);
+        REQUIRE(ids() == std::vector{root.id(), a.id(), a1.id(), b.id(), b1.id(), a2.id()});
+        REQUIRE(size_of(a) == 5);
+        REQUIRE(ctx.hierarchy()[5].parent == 1);
+        REQUIRE(b1.is_ancestor_of(b1) == false);
+        REQUIRE(a.is_ancestor_of(b1));
+    }
+
+    SECTION("Reparent to an ancestor") {
+        a1.reparent(root);
+        REQUIRE(ids() == std::vector{root.id(), a.id(), a2.id(), b.id(), b1.id(), a1.id()});
+        REQUIRE(size_of(a) == 2);
+        REQUIRE(ctx.hierarchy()[3].parent == 0);
+    }
+
+    SECTION("Depth") {
+        REQUIRE(root.depth() == 0);
+        REQUIRE(a.depth() == 1);
+        REQUIRE(a1.depth() == 2);
+        a.reparent(b1);
+        REQUIRE(a.depth() == 3);
+        REQUIRE(a2.depth() == 4);
+        a.reparent(root);
+        REQUIRE(a1.depth() == 2);
+        REQUIRE(a.add_child().depth() == 2);
+    }
+
+    SECTION("Destroy child") {
+        root.destroy_child(a.id());
+        REQUIRE(ids() == std::vector{root.id(), b.id(), b1.id()});
+        REQUIRE(size_of(root) == 3);
+        REQUIRE(ctx.hierarchy()[2].parent == 1);
+    }
+
+    SECTION("First entity") {
+        REQUIRE(a.subtree().front().first_entity.is_null());
+        const auto en = a.entities().create();
+        a.entities().create();
+        REQUIRE(a.subtree().front().first_entity == en);
+        root.destroy_children();
+        REQUIRE(ctx.hierarchy().size() == 1);
+    }
+}
+
+TEST_CASE("Stale node ids") {
+    st::tree_context ctx;
+    auto &root = ctx.root();
+    const auto old_id = root.add_child().id();
+    root.destroy_child(old_id);
+    REQUIRE_FALSE(ctx.contains(old_id));
+
+    auto &reused = root.add_child();
+    REQUIRE(reused.id() != old_id);
+    REQUIRE(ctx.contains(reused.id()));
+    REQUIRE(&ctx.get_node(reused.id()) == &reused);
+}
+
+TEST_CASE("Node churn benchmark", "[.][benchmark]") {
+    constexpr int churn_count = 1'000'000;
+    st::tree_context ctx;
+    auto &root = ctx.root();
+    BENCHMARK("Create and destroy 1M nodes") {
+        for(int i = 0; i < churn_count; ++i) {
+            root.destroy_child(root.add_child().id());
+        }
+        return ctx.hierarchy().size();
+    };
+    BENCHMARK("Look up 1M node ids") {
+        std::vector<st::node::id_type> ids;
+        for(int i = 0; i < 1000; ++i) {
+            ids.push_back(root.add_child().id());
+        }
+        std::size_t found{};
+        for(int i = 0; i < churn_count; ++i) {
+            found += ctx.get_node(ids[static_cast<std::size_t>(i) % ids.size()]).entities().size();
+        }
+        root.destroy_children();
+        return found;
+    };
+}
+
+TEST_CASE("Flattened hierarchy benchmark", "[.][benchmark]") {
+    constexpr int node_count = 100'000;
+    constexpr int fan_out = 8;
+    st::tree_context ctx;
+    std::vector<st::node *> nodes{&ctx.root()};
+    nodes.reserve(node_count);
+    for(int i = 1; i < node_count; ++i) {
+        nodes.push_back(&nodes[(i - 1) / fan_out]->add_child());
+        nodes.back()->entities().create();
+    }
+
+    BENCHMARK("Build 100k nodes breadth-first") {
+        st::tree_context built;
+        std::vector<st::node *> parents{&built.root()};
+        parents.reserve(node_count);
+        for(int i = 1; i < node_count; ++i) {
+            parents.push_back(&parents[(i - 1) / fan_out]->add_child());
+        }
+        return built.hierarchy().size();
+    };
+    BENCHMARK("Traverse 100k nodes") {
+        std::size_t count{};
+        ctx.root().traverse([&count](st::node &cur) { count += cur.entities().size(); });
+        return count;
+    };
+    BENCHMARK("Propagate depth over 100k nodes") {
+        std::size_t total{};
+        const auto accumulate = [&total](st::node &, std::size_t depth) {
+            total += depth;
+            return depth + 1;
+        };
+        ctx.root().traverse(accumulate, std::size_t{});
+        return total;
+    };
+    BENCHMARK("Reparent a subtree") {
+        auto &moved = *nodes[fan_out];
+        moved.reparent(moved.parent().is_root() ? *nodes[node_count - 1] : ctx.root());
+        return ctx.hierarchy().size();
+    };
+}
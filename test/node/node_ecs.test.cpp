@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <span>
+#include <vector>
 #include <catch2/catch_all.hpp>
 import stay3.node;
 import stay3.ecs;
@@ -22,6 +24,20 @@ TEST_CASE("Entity to node mapping") {
         REQUIRE((&context.get_node(en)) == (&child1));
     }
 
+    SECTION("Bulk created entities are added to mapping") {
+        auto &child = root.add_child();
+        const auto entities = child.entities().create_n(10);
+        for(auto en: entities) {
+            REQUIRE((&context.get_node(en)) == &child);
+        }
+        const std::vector<entity> destroyed{entities.begin(), entities.end()};
+        child.entities().destroy_all();
+        for(auto en: destroyed) {
+            REQUIRE_FALSE(context.ecs().contains(en));
+        }
+        REQUIRE(child.entities().is_empty());
+    }
+
     SECTION("Deleted entity is removed from ecs registry") {
         SECTION("Deleted by entities holder") {
             auto en = root.entities().create();
@@ -36,6 +52,27 @@ TEST_CASE("Entity to node mapping") {
             REQUIRE_FALSE(std::ranges::contains(holder, en));
         }
     }
+
+    SECTION("Ownership is a component") {
+        auto &child = root.add_child();
+        const auto owned = child.entities().create();
+        const auto stray = context.ecs().create();
+        REQUIRE(context.ecs().get<node_owner>(owned)->id == child.id());
+        REQUIRE_FALSE(context.ecs().contains<node_owner>(stray));
+
+        struct owner_listener {
+            tree_context *ctx;
+            node *owner{};
+            void on_destroy(ecs_registry &, entity en) {
+                owner = &ctx->get_node(en);
+            }
+        } listener{&context};
+        context.ecs().emplace<int>(owned);
+        context.ecs().on<comp_event::destroy, int>().connect<&owner_listener::on_destroy>(listener);
+        context.ecs().destroy(owned);
+        REQUIRE(listener.owner == &child);
+        REQUIRE(child.entities().is_empty());
+    }
 }
 
 struct event_listener {
@@ -96,4 +133,94 @@ TEST_CASE("Entities event") {
             REQUIRE(lis.node == &child);
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Subtree teardown") {
+    tree_context context;
+    auto &root = context.root();
+    auto &child = root.add_child();
+    auto &grandchild = child.add_child();
+    const auto root_en = root.entities().create();
+    std::vector<entity> subtree_entities{child.entities().create(), child.entities().create()};
+    const auto created = grandchild.entities().create_n(100);
+    subtree_entities.insert(subtree_entities.end(), created.begin(), created.end());
+
+    struct batch_listener {
+        std::vector<entity> entities;
+        int calls{};
+        void on_batch(std::span<const entity> batch) {
+            entities.insert(entities.end(), batch.begin(), batch.end());
+            ++calls;
+        }
+    } batch;
+    event_listener single;
+    context.on_entities_destroyed().connect<&batch_listener::on_batch>(batch);
+    context.on_entity_destroyed().connect<&event_listener::on_event>(single);
+
+    SECTION("Destroy child") {
+        root.destroy_child(child.id());
+        REQUIRE(batch.calls == 1);
+        REQUIRE(batch.entities.size() == subtree_entities.size());
+        REQUIRE(single.en == subtree_entities.back());
+        REQUIRE(single.node == &grandchild);
+        for(auto en: subtree_entities) {
+            REQUIRE_FALSE(context.ecs().contains(en));
+            REQUIRE(std::ranges::contains(batch.entities, en));
+        }
+        REQUIRE(context.ecs().contains(root_en));
+        REQUIRE((&context.get_node(root_en)) == &root);
+    }
+
+    SECTION("Destroy children") {
+        root.add_child().entities().create();
+        root.destroy_children();
+        REQUIRE(batch.calls == 1);
+        REQUIRE(batch.entities.size() == subtree_entities.size() + 1);
+        REQUIRE(root.begin() == root.end());
+        REQUIRE(context.ecs().contains(root_en));
+    }
+
+    SECTION("Destroy tree") {
+        context.destroy_tree();
+        REQUIRE(batch.calls == 1);
+        REQUIRE(batch.entities.size() == subtree_entities.size() + 1);
+        REQUIRE_FALSE(context.ecs().contains(root_en));
+    }
+
+    SECTION("Listeners see ownership during teardown") {
+        struct component_listener {
+            tree_context *context;
+            int owned_count{};
+            void on_destroy(ecs_registry &, entity en) {
+                REQUIRE(context->is_tearing_down());
+                const auto &owner = context->get_node(en);
+                if(owner.entities().contains(en)) {
+                    ++owned_count;
+                }
+            }
+        } lis{&context};
+        struct tag {};
+        for(auto en: subtree_entities) {
+            context.ecs().emplace<tag>(en);
+        }
+        context.ecs().on<comp_event::destroy, tag>().connect<&component_listener::on_destroy>(lis);
+        root.destroy_child(child.id());
+        REQUIRE(lis.owned_count == static_cast<int>(subtree_entities.size()));
+    }
+}
+
+TEST_CASE("Prefab instantiation under node") {
+    struct health {
+        int value;
+    };
+    tree_context context;
+    auto &child = context.root().add_child();
+    constexpr std::size_t count = 4;
+
+    const auto entities = instantiate(context, child, prefab{health{.value = 3}}, count);
+    REQUIRE(entities.size() == count);
+    REQUIRE(child.entities().size() == count);
+    for(const auto en: entities) {
+        REQUIRE(&context.get_node(en) == &child);
+        REQUIRE(context.ecs().get<health>(en)->value == 3);
+    }
+}
@@ -0,0 +1,187 @@
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <catch2/catch_all.hpp>
+import stay3.core;
+import stay3.node;
+import stay3.ecs;
+
+using namespace st;
+
+namespace {
+struct position {
+    int value;
+};
+struct label {
+    std::string name;
+};
+struct marker {};
+struct target {
+    entity en;
+};
+struct unsaved {};
+} // namespace
+
+template<>
+struct st::snapshot_id<position>: std::integral_constant<std::uint32_t, 1> {};
+template<>
+struct st::snapshot_id<label>: std::integral_constant<std::uint32_t, 2> {};
+template<>
+struct st::snapshot_id<marker>: std::integral_constant<std::uint32_t, 3> {};
+template<>
+struct st::snapshot_id<target>: std::integral_constant<std::uint32_t, 4> {};
+
+template<>
+struct st::snapshot_traits<position>: trivial_snapshot_traits<position> {};
+
+template<>
+struct st::snapshot_traits<label> {
+    static void save(snapshot_writer &out, const label &value) {
+        out.write(std::vector<char>{value.name.begin(), value.name.end()});
+    }
+    static void load(snapshot_reader &in, label &value) {
+        std::vector<char> chars;
+        in.read(chars);
+        value.name.assign(chars.begin(), chars.end());
+    }
+};
+
+template<>
+struct st::snapshot_traits<target> {
+    static void save(snapshot_writer &out, const target &value) {
+        out.write(value.en);
+    }
+    static void load(snapshot_reader &in, target &value) {
+        value.en = in.read_entity();
+    }
+};
+
+namespace {
+void save_scene(tree_context &ctx, snapshot_writer &out) {
+    save_snapshot<position, label, marker, target, transform>(ctx, out);
+}
+void load_scene(tree_context &ctx, snapshot_reader &in) {
+    load_snapshot<position, label, marker, target, transform>(ctx, in);
+}
+} // namespace
+
+TEST_CASE("Tree snapshot") {
+    tree_context saved;
+    auto &reg = saved.ecs();
+    auto &root = saved.root();
+    const auto root_en = root.entities().create();
+    reg.emplace<label>(root_en, "root");
+    auto &child = root.add_child();
+    const auto child_en = child.entities().create();
+    const auto child_en2 = child.entities().create();
+    reg.emplace<position>(child_en, 3);
+    reg.emplace<marker>(child_en2);
+    reg.emplace<target>(child_en2, child_en);
+    reg.emplace<unsaved>(child_en2);
+    auto &grandchild = child.add_child();
+    const auto grandchild_en = grandchild.entities().create();
+    reg.emplace<transform>(grandchild_en, transform{}.set_position({1.F, 2.F, 3.F}));
+    // Stray entities are not owned by any node
+    reg.emplace<position>(reg.create(), 10);
+
+    snapshot_writer out;
+    save_scene(saved, out);
+
+    SECTION("Hierarchy and components are restored") {
+        tree_context loaded;
+        loaded.root().add_child().entities().create();
+        snapshot_reader in{out.data()};
+        load_scene(loaded, in);
+        REQUIRE(in.is_end());
+
+        auto &loaded_reg = loaded.ecs();
+        auto &loaded_root = loaded.root();
+        REQUIRE(loaded_root.entities().size() == 1);
+        REQUIRE(loaded_reg.get<label>(loaded_root.entities()[0])->name == "root");
+
+        REQUIRE(loaded_root.begin() != loaded_root.end());
+        auto &loaded_child = *loaded_root.begin();
+        REQUIRE(loaded_child.entities().size() == 2);
+        const auto loaded_child_en = loaded_child.entities()[0];
+        const auto loaded_child_en2 = loaded_child.entities()[1];
+        REQUIRE(loaded_reg.get<position>(loaded_child_en)->value == 3);
+        REQUIRE(loaded_reg.contains<marker>(loaded_child_en2));
+        REQUIRE_FALSE(loaded_reg.contains<unsaved>(loaded_child_en2));
+        REQUIRE(loaded_reg.get<target>(loaded_child_en2)->en == loaded_child_en);
+        REQUIRE(&loaded.get_node(loaded_child_en2) == &loaded_child);
+
+        auto &loaded_grandchild = *loaded_child.begin();
+        REQUIRE(&loaded_grandchild.parent() == &loaded_child);
+        const auto &tf = *loaded_reg.get<transform>(loaded_grandchild.entities()[0]);
+        REQUIRE(tf.position() == vec3f{1.F, 2.F, 3.F});
+
+        std::uint32_t stray_count{};
+        for(auto [en, pos]: loaded_reg.each<position>()) {
+            if(pos->value == 10) {
+                ++stray_count;
+            }
+        }
+        REQUIRE(stray_count == 1);
+    }
+
+    SECTION("Construct handlers see restored ownership") {
+        tree_context loaded;
+        struct listener {
+            tree_context *ctx;
+            bool owned{};
+            void on_construct(ecs_registry &, entity en) {
+                owned = &ctx->get_node(en) != &ctx->root();
+            }
+        } lis{&loaded};
+        loaded.ecs().on<comp_event::construct, transform>().connect<&listener::on_construct>(lis);
+        snapshot_reader in{out.data()};
+        load_scene(loaded, in);
+        REQUIRE(lis.owned);
+    }
+
+    SECTION("Mismatched component types are rejected") {
+        tree_context loaded;
+        snapshot_reader in{out.data()};
+        REQUIRE_THROWS_AS((load_snapshot<label, position>(loaded, in)), snapshot_error);
+    }
+
+    SECTION("Truncated snapshots are rejected and keep the scene") {
+        tree_context loaded;
+        const auto kept = loaded.root().add_child().entities().create();
+        loaded.ecs().emplace<position>(kept, 7);
+        snapshot_reader in{out.data().first(out.data().size() / 2)};
+        REQUIRE_THROWS_AS(load_scene(loaded, in), snapshot_error);
+        REQUIRE(loaded.ecs().contains(kept));
+        REQUIRE(loaded.ecs().get<position>(kept)->value == 7);
+        REQUIRE(&loaded.get_node(kept) != &loaded.root());
+    }
+
+    SECTION("Entities missing from the snapshot are rejected") {
+        tree_context other;
+        entity unknown;
+        for(int i = 0; i < 100; ++i) {
+            unknown = other.root().entities().create();
+        }
+        reg.get<mut<target>>(child_en2)->en = unknown;
+        snapshot_writer dangling;
+        save_scene(saved, dangling);
+        tree_context loaded;
+        snapshot_reader in{dangling.data()};
+        REQUIRE_THROWS_AS(load_scene(loaded, in), snapshot_error);
+    }
+
+    SECTION("Snapshot file is memory mapped") {
+        const auto path = std::filesystem::temp_directory_path() / "stay3_snapshot.test.bin";
+        save_snapshot<position, label, marker, target, transform>(saved, path);
+        {
+            const mapped_file file{path};
+            REQUIRE(file.data().size() == out.data().size());
+        }
+        tree_context loaded;
+        load_snapshot<position, label, marker, target, transform>(loaded, path);
+        REQUIRE(loaded.root().entities().size() == 1);
+        std::filesystem::remove(path);
+    }
+}
@@ -1,4 +1,6 @@
+#include <cstddef>
 #include <numbers>
+#include <vector>
 
 #include <catch2/catch_all.hpp>
 import stay3;
@@ -200,4 +202,237 @@ TEST_CASE("Happy path") {
 
         my_app.run();
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Parallel sync of wide levels") {
+    // Enough children per level to be split across threads
+    constexpr std::size_t children_per_root = 1500;
+    constexpr std::size_t root_count = 2;
+    thread_pool pool{4};
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    std::vector<entity> roots;
+    std::vector<entity> grandchildren;
+    for(std::size_t r = 0; r < root_count; ++r) {
+        auto &root_node = ctx.root().add_child();
+        roots.push_back(root_node.entities().create());
+        reg.emplace<transform>(roots.back());
+        for(std::size_t i = 0; i < children_per_root; ++i) {
+            auto &child = root_node.add_child();
+            reg.emplace<mut<transform>>(child.entities().create())->translate(vec_up);
+            grandchildren.push_back(child.add_child().entities().create());
+            reg.emplace<mut<transform>>(grandchildren.back())->translate(vec_forward);
+        }
+    }
+    sync_global_transform(ctx, pool);
+
+    std::size_t updates{};
+    struct counter {
+        std::size_t *count;
+        void on_update(ecs_registry &, entity) {
+            ++*count;
+        }
+    } update_counter{&updates};
+    reg.on<comp_event::update, global_transform>().connect<&counter::on_update>(update_counter);
+
+    for(auto en: roots) {
+        reg.get<mut<transform>>(en)->translate(vec_right * 2.F);
+    }
+    sync_global_transform(ctx, pool);
+
+    REQUIRE(updates == root_count * (1 + (2 * children_per_root)));
+    for(auto en: grandchildren) {
+        REQUIRE(approx_equal(reg.get<global_transform>(en)->get().position(), (vec_right * 2.F) + vec_up + vec_forward));
+    }
+}
+
+TEST_CASE("Sheared global matrices") {
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    // Rotated children of a non-uniformly scaled parent have shear
+    const transform parent_tf{vec3f{4.F, 0.F, -1.F}, quaternionf{vec3f{-3.F, 1.F, 2.F}.normalized(), 1.9F}, vec3f{1.F, 3.F, 2.F}};
+    const transform local{vec3f{1.F, -2.F, 0.5F}, quaternionf{vec3f{1.F, 2.F, -1.F}.normalized(), 0.7F}, vec3f{0.5F, 2.F, 3.F}};
+    auto &parent_node = ctx.root().add_child();
+    const auto parent = parent_node.entities().create();
+    reg.emplace<transform>(parent, parent_tf);
+    auto &child_node = parent_node.add_child();
+    const auto child = child_node.entities().create();
+    reg.emplace<transform>(child, local);
+    const auto grandchild = child_node.add_child().entities().create();
+    reg.emplace<transform>(grandchild, local);
+    sync_global_transform(ctx);
+
+    SECTION("Exact matrices are kept aside") {
+        const mat4f child_world = parent_tf.matrix() * local.matrix();
+        REQUIRE_FALSE(reg.contains<sheared_global_matrix>(parent));
+        REQUIRE(reg.contains<sheared_global_matrix>(child));
+        REQUIRE(reg.contains<sheared_global_matrix>(grandchild));
+        REQUIRE(approx_equal(global_matrix(ctx, child), child_world));
+        REQUIRE(approx_equal(global_matrix(ctx, grandchild), child_world * local.matrix()));
+
+        const std::vector<entity> batch{parent, child, grandchild};
+        std::vector<mat4f> matrices(batch.size());
+        global_matrices(ctx, batch, matrices);
+        REQUIRE(approx_equal(matrices[0], parent_tf.matrix()));
+        REQUIRE(approx_equal(matrices[1], child_world));
+        REQUIRE(approx_equal(matrices[2], child_world * local.matrix()));
+    }
+
+    SECTION("Removed once the parent scales uniformly") {
+        reg.get<mut<transform>>(parent)->set_scale(2.F);
+        sync_global_transform(ctx);
+        REQUIRE_FALSE(reg.contains<sheared_global_matrix>(child));
+        REQUIRE_FALSE(reg.contains<sheared_global_matrix>(grandchild));
+        const mat4f child_world = reg.get<transform>(parent)->matrix() * local.matrix();
+        REQUIRE(approx_equal(global_matrix(ctx, grandchild), child_world * local.matrix()));
+    }
+
+    SECTION("Wide level with sheared and exact transforms") {
+        constexpr std::size_t children = 1500;
+        thread_pool pool{4};
+        std::vector<entity> wide;
+        for(std::size_t i = 0; i < children; ++i) {
+            wide.push_back(parent_node.add_child().entities().create());
+            const bool rotated = i % 2 == 0;
+            reg.emplace<transform>(wide.back(), rotated ? local : transform{local.position()});
+        }
+        sync_global_transform(ctx, pool);
+        for(std::size_t i = 0; i < children; ++i) {
+            const auto &child_local = *reg.get<transform>(wide[i]);
+            REQUIRE(reg.contains<sheared_global_matrix>(wide[i]) == (i % 2 == 0));
+            REQUIRE(approx_equal(global_matrix(ctx, wide[i]), parent_tf.matrix() * child_local.matrix()));
+        }
+    }
+}
+
+TEST_CASE("Transform sync benchmark", "[.][benchmark]") {
+    constexpr int chain_count = 16;
+    constexpr int depth = 500;
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    std::vector<entity> chain_roots;
+    for(int chain = 0; chain < chain_count; ++chain) {
+        auto *cur = &ctx.root().add_child();
+        chain_roots.push_back(cur->entities().create());
+        reg.emplace<transform>(chain_roots.back());
+        for(int level = 1; level < depth; ++level) {
+            cur = &cur->add_child();
+            reg.emplace<mut<transform>>(cur->entities().create())->translate(vec_up);
+        }
+    }
+    sync_global_transform(ctx);
+
+    BENCHMARK("Sync 16 chains of 500 nodes") {
+        for(auto en: chain_roots) {
+            reg.get<mut<transform>>(en)->translate(vec_right);
+        }
+        sync_global_transform(ctx);
+        return reg.get<global_transform>(chain_roots.front())->get().position();
+    };
+}
+
+TEST_CASE("Sparse transform sync benchmark", "[.][benchmark]") {
+    constexpr std::size_t node_count = 50'000;
+    constexpr std::size_t branching = 4;
+    // Nodes after the first quarter of a complete 4-ary tree are leaves
+    constexpr std::size_t first_leaf = node_count / branching;
+    constexpr std::size_t changed_count = node_count / 100;
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    std::vector<node *> nodes{&ctx.root()};
+    std::vector<entity> entities;
+    nodes.reserve(node_count);
+    entities.reserve(node_count);
+    for(std::size_t i = 0; i < node_count; ++i) {
+        if(i > 0) {
+            nodes.push_back(&nodes[(i - 1) / branching]->add_child());
+        }
+        entities.push_back(nodes.back()->entities().create());
+        reg.emplace<mut<transform>>(entities.back())->translate(vec_up);
+    }
+    sync_global_transform(ctx);
+
+    std::size_t round{};
+    BENCHMARK("Sync 1% of 50k nodes") {
+        ++round;
+        for(std::size_t i = 0; i < changed_count; ++i) {
+            const auto leaf = first_leaf + ((round + (i * 37)) % (node_count - first_leaf));
+            reg.get<mut<transform>>(entities[leaf])->translate(vec_right);
+        }
+        sync_global_transform(ctx);
+        return reg.get<global_transform>(entities.back())->get().position();
+    };
+}
+
+TEST_CASE("Wide transform sync benchmark", "[.][benchmark]") {
+    constexpr int root_count = 4;
+    constexpr int children_per_root = 10'000;
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    std::vector<entity> roots;
+    for(int r = 0; r < root_count; ++r) {
+        auto &root_node = ctx.root().add_child();
+        roots.push_back(root_node.entities().create());
+        reg.emplace<transform>(roots.back());
+        for(int i = 0; i < children_per_root; ++i) {
+            reg.emplace<mut<transform>>(root_node.add_child().entities().create())->translate(vec_up);
+        }
+    }
+    sync_global_transform(ctx);
+
+    thread_pool serial{1};
+    BENCHMARK("Sync 4 roots with 10k children each, serial") {
+        for(auto en: roots) {
+            reg.get<mut<transform>>(en)->translate(vec_right);
+        }
+        sync_global_transform(ctx, serial);
+        return reg.get<global_transform>(roots.front())->get().position();
+    };
+    BENCHMARK("Sync 4 roots with 10k children each, parallel") {
+        for(auto en: roots) {
+            reg.get<mut<transform>>(en)->translate(vec_right);
+        }
+        sync_global_transform(ctx, default_thread_pool());
+        return reg.get<global_transform>(roots.front())->get().position();
+    };
+}
+
+TEST_CASE("World matrices benchmark", "[.][benchmark]") {
+    constexpr std::size_t count = 100'000;
+    tree_context ctx;
+    transform_sync_system::start(ctx);
+    auto &reg = ctx.ecs();
+
+    auto &parent_node = ctx.root().add_child();
+    reg.emplace<mut<transform>>(parent_node.entities().create())->set_scale(2.F);
+    auto &children_node = parent_node.add_child();
+    std::vector<entity> entities;
+    entities.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        entities.push_back(children_node.entities().create());
+        reg.emplace<mut<transform>>(entities.back())->translate(vec_up * static_cast<float>(i));
+    }
+    sync_global_transform(ctx);
+    std::vector<mat4f> matrices(count);
+
+    BENCHMARK("Read positions of 100k global transforms") {
+        vec3f sum{0.F};
+        for(auto &&[en, global]: reg.each<global_transform>()) {
+            sum += global->get().position();
+        }
+        return sum;
+    };
+    BENCHMARK("World matrices of 100k entities") {
+        global_matrices(ctx, entities, matrices);
+        return matrices.back()[3].y;
+    };
+}
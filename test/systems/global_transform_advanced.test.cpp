@@ -56,6 +56,18 @@ void check_reparent_update(tree_context &ctx, const entities &es) {
     REQUIRE(approx_equal(depth3_tf->get().scale(), vec3f{1.F}));
 }
 
+void check_dirty_reparent_update(tree_context &ctx, const entities &es) {
+    sync_global_transform(ctx);
+    // Both are dirty at the same depth, then one moves below the other
+    ctx.ecs().get<mut<transform>>(es.depth31)->scale(3.F);
+    ctx.ecs().get<mut<transform>>(es.depth32)->scale(2.F);
+    ctx.get_node(es.depth31).reparent(ctx.get_node(es.depth32));
+    sync_global_transform(ctx);
+
+    auto depth3_tf = ctx.ecs().get<global_transform>(es.depth31);
+    REQUIRE(approx_equal(depth3_tf->get().scale(), vec3f{6.F}));
+}
+
 void check_parent_entity_removed_update(tree_context &ctx, const entities &es) {
     ctx.ecs().get<mut<transform>>(es.depth2)->scale(3.F);
     sync_global_transform(ctx);
@@ -122,6 +134,7 @@ void check_parent_transform_added_update(tree_context &ctx, const entities &es)
 
 STAY3_TEST_SYSTEM(check_transitive_update);
 STAY3_TEST_SYSTEM(check_reparent_update);
+STAY3_TEST_SYSTEM(check_dirty_reparent_update);
 STAY3_TEST_SYSTEM(check_parent_entity_added_update);
 STAY3_TEST_SYSTEM(check_parent_entity_removed_update);
 STAY3_TEST_SYSTEM(check_parent_transform_added_update);